@@ -0,0 +1,35 @@
+/*
+* batch.h
+* Coded by iosmen (c) 2025
+*/
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "utils.h"
+#include "macho.h"
+
+// Batch scanning options
+typedef struct {
+    uint32_t nthreads;          // Worker threads, 0 means one per CPU
+    uint32_t max_pending;       // Queued files before the walker blocks, 0 means 4 per thread
+    const char* arch_name;      // Only this architecture of FAT files
+    int all_archs;              // Every architecture of FAT files
+    int verify;                 // Re-hash the signed pages of every slice
+    int cdhash;                 // Append the cdhash of the preferred CodeDirectory
+} batch_options_t;
+
+// Counters reported when the batch finishes
+typedef struct {
+    uint32_t files;
+    uint32_t machos;
+    uint32_t slices;
+    uint32_t errors;
+    uint32_t invalid;           // Slices whose signature failed --verify
+} batch_stats_t;
+
+// Function prototypes
+int is_macho_file(const char* path);
+macho_error_t run_batch(const char* const* inputs, uint32_t ninputs, const char* manifest,
+                        const batch_options_t* opts, batch_stats_t* stats);
+
+#endif // BATCH_H
@@ -6,6 +6,7 @@
 #define CSBLOB_H
 
 #include "utils.h"
+#include "output.h"
 #include <mach-o/loader.h>
 #include "macho.h"
 
@@ -40,8 +41,114 @@ typedef struct __CodeDirectory {
     // Variable data follows
 } CS_CodeDirectory;
 
+// Code signature magic numbers
+#define CSMAGIC_REQUIREMENTS                0xfade0c01
+#define CSMAGIC_CODEDIRECTORY               0xfade0c02
+#define CSMAGIC_EMBEDDED_SIGNATURE          0xfade0cc0
+#define CSMAGIC_EMBEDDED_ENTITLEMENTS       0xfade7171
+#define CSMAGIC_EMBEDDED_DER_ENTITLEMENTS   0xfade7172
+#define CSMAGIC_BLOBWRAPPER                 0xfade0b01
+
+// SuperBlob slots
+#define CSSLOT_CODEDIRECTORY                0
+#define CSSLOT_INFOSLOT                     1
+#define CSSLOT_REQUIREMENTS                 2
+#define CSSLOT_RESOURCEDIR                  3
+#define CSSLOT_APPLICATION                  4
+#define CSSLOT_ENTITLEMENTS                 5
+#define CSSLOT_DER_ENTITLEMENTS             7
+#define CSSLOT_ALTERNATE_CODEDIRECTORIES    0x1000
+#define CSSLOT_ALTERNATE_CODEDIRECTORY_MAX  5
+#define CSSLOT_SIGNATURESLOT                0x10000
+#define CSSLOT_IDENTIFICATIONSLOT           0x10001
+#define CSSLOT_TICKETSLOT                   0x10002
+
+// CodeDirectory hash types
+#define CS_HASHTYPE_SHA1                1
+#define CS_HASHTYPE_SHA256              2
+#define CS_HASHTYPE_SHA256_TRUNCATED    3
+#define CS_HASHTYPE_SHA384              4
+
+// A cdhash is the CodeDirectory digest truncated to 20 bytes
+#define CS_CDHASH_LEN 20
+
+// Slot 0 plus the alternates in 0x1000 to 0x1004
+#define CS_MAX_CODE_DIRECTORIES 6
+
+// Bounds-checked view of signature bytes, read through the cs_span_* helpers
+typedef struct {
+    const uint8_t* data;
+    uint32_t size;
+} cs_span_t;
+
+// One CodeDirectory of the signature
+typedef struct {
+    uint32_t slot;
+    cs_span_t blob;                 // Whole blob, header included
+    uint8_t hash_type;
+    int has_cdhash;                 // Unset for hash types we cannot compute
+    uint8_t cdhash[CS_CDHASH_LEN];
+} cs_code_directory_t;
+
+// SuperBlob index entry, checked against the signature once when decoded
+typedef struct {
+    uint32_t type;
+    uint32_t offset;                // From the start of the SuperBlob
+    uint32_t magic;
+    uint32_t length;                // As declared, blob.size is clamped to the signature
+    cs_span_t blob;                 // Header included, empty when the header is out of range
+    int truncated;                  // Declared length runs past the signature
+} cs_blob_t;
+
+// SuperBlob decoded once per context, see get_code_signature()
+typedef struct {
+    uint32_t offset;                // LC_CODE_SIGNATURE dataoff and datasize
+    uint32_t size;
+    uint32_t magic;
+    uint32_t length;                // Declared SuperBlob length and blob count
+    uint32_t count;
+    const char* error;              // Why the SuperBlob was rejected, NULL without LC_CODE_SIGNATURE
+    cs_span_t superblob;            // Clamped to both length and datasize
+    cs_blob_t* blobs;               // Index entries that fit in the signature
+    uint32_t nblobs;
+    cs_code_directory_t dirs[CS_MAX_CODE_DIRECTORIES];
+    uint32_t ndirs;
+} cs_signature_t;
+
+// Mismatching code slots listed per CodeDirectory, the rest are only counted
+#define CS_VERIFY_MAX_REPORTED 16
+
+// Outcome of re-hashing the pages and embedded blobs one CodeDirectory covers
+typedef struct {
+    uint32_t slot;                  // SuperBlob slot of the CodeDirectory
+    uint8_t hash_type;
+    const char* error;              // Malformed CodeDirectory, nothing was compared
+    uint64_t code_limit;
+    uint32_t page_size;             // 0 when one hash covers the whole code limit
+    uint32_t code_slots;
+    uint32_t bad_code_slots;
+    uint32_t bad_slots[CS_VERIFY_MAX_REPORTED];
+    uint32_t special_slots;         // Special slots that seal a blob
+    uint32_t bad_special_slots;
+    uint32_t bad_special[CS_VERIFY_MAX_REPORTED];       // Slot numbers, in slot order
+    const char* bad_special_reason[CS_VERIFY_MAX_REPORTED];
+} cs_verify_t;
+
 // Function prototypes
-macho_error_t parse_code_signature(const macho_ctx_t* ctx);
+int cs_span_read32(cs_span_t span, uint32_t offset, uint32_t* value);
+int cs_span_sub(cs_span_t span, uint32_t offset, uint32_t length, cs_span_t* sub);
+macho_error_t get_code_signature(const macho_ctx_t* ctx, const cs_signature_t** signature);
+const cs_blob_t* cs_find_blob(const cs_signature_t* signature, uint32_t type, uint32_t magic);
+void free_code_signature(cs_signature_t* signature);
+macho_error_t parse_code_signature(output_t* out, const macho_ctx_t* ctx);
+macho_error_t get_code_directories(const macho_ctx_t* ctx, const cs_code_directory_t** dirs, uint32_t* count);
+int preferred_code_directory(const cs_code_directory_t* dirs, uint32_t count);
+macho_error_t compute_cdhash(const macho_ctx_t* ctx, uint8_t* cdhash, uint8_t* hash_type);
+const char* cs_hash_type_name(uint8_t hash_type);
+void format_cdhash(const uint8_t* cdhash, char* str);
+macho_error_t verify_code_signature(const macho_ctx_t* ctx, uint32_t nthreads, cs_verify_t** results, uint32_t* count);
+int code_signature_valid(const cs_verify_t* results, uint32_t count);
+int print_signature_verification(output_t* out, const macho_ctx_t* ctx, uint32_t nthreads);
 macho_error_t find_code_signature(const macho_ctx_t* ctx, uint32_t* offset, uint32_t* size);
 void print_code_signature_info(const CS_SuperBlob* superblob);
 
@@ -0,0 +1,25 @@
+/*
+* digest.h
+* Coded by iosmen (c) 2025
+*/
+#ifndef DIGEST_H
+#define DIGEST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Hash functions used by code signatures
+typedef enum {
+    DIGEST_SHA1 = 0,
+    DIGEST_SHA256,
+    DIGEST_SHA384
+} digest_type_t;
+
+#define DIGEST_MAX_SIZE 48
+
+// Function prototypes
+size_t digest_size(digest_type_t type);
+const char* digest_name(digest_type_t type);
+void digest_buffer(digest_type_t type, const void* data, size_t len, uint8_t* out);
+
+#endif // DIGEST_H
@@ -2,11 +2,15 @@
 * disasm.h
 * Coded by iosmen (c) 2025
 */
-#ifndef LOAD_COMMANDS_H
-#define LOAD_COMMANDS_H
+#ifndef DISASM_H
+#define DISASM_H
 
 #include "macho.h"
 #include "utils.h"
+#include "output.h"
+#include "load_commands.h"
+#include "symbols.h"
+#include "threadpool.h"
 #include <mach-o/loader.h>
 #include <capstone/capstone.h>
 
@@ -17,45 +21,41 @@ typedef struct {
     uint8_t* code;
 } disasm_ctx_t;
 
-// Load command types
+// Capstone engine used for a Mach-O CPU type
 typedef struct {
-    uint32_t cmd;
-    uint32_t cmdsize;
-    void* data;
-} load_command_t;
+    cpu_type_t cputype;
+    cs_arch arch;
+    cs_mode mode;
+    const char* name;
+} disasm_arch_t;
 
-// Segment and section information
-typedef struct {
-    char segname[16];
-    char sectname[16];
-    uint64_t addr;
-    uint64_t size;
-    uint32_t offset;
-    uint32_t align;
-    uint32_t reloff;
-    uint32_t nreloc;
-    uint32_t flags;
-} section_info_t;
+// Engine options, detail is off unless a consumer needs operands
+#define DISASM_DETAIL   0x1     // Fill cs_insn.detail (operands, groups, registers)
+#define DISASM_SKIPDATA 0x2     // Emit data as .byte and keep going instead of stopping
 
+// What to disassemble, zero values select every code section
 typedef struct {
-    char segname[16];
-    uint64_t vmaddr;
-    uint64_t vmsize;
-    uint64_t fileoff;
-    uint64_t filesize;
-    vm_prot_t maxprot;
-    vm_prot_t initprot;
-    uint32_t nsects;
-    uint32_t flags;
-    section_info_t* sections;
-} segment_info_t;
+    uint64_t start_address;     // First address to decode, 0 for the section start
+    uint64_t stop_address;      // Address to stop at, 0 for the section end
+    const char* symbol;         // Decode from this symbol up to the next one
+    uint32_t nthreads;          // Worker threads, 0 means one per CPU
+    uint32_t flags;             // DISASM_DETAIL, DISASM_SKIPDATA
+} disasm_options_t;
 
-// Function prototypes
-macho_error_t parse_load_commands(macho_ctx_t* ctx);
-void print_load_commands(const macho_ctx_t* ctx);
-macho_error_t parse_segment_commands(macho_ctx_t* ctx, segment_info_t** segments, uint32_t* nsegments);
-void free_segments(segment_info_t* segments, uint32_t nsegments);
+// Bytes of fixed-width code decoded per task in full-section mode
+#define DISASM_CHUNK_SIZE (64 * 1024)
 
+// Function prototypes
+macho_error_t init_disassembler(disasm_ctx_t* ctx, cs_arch arch, cs_mode mode, uint32_t flags);
+void free_disassembler(disasm_ctx_t* ctx);
+macho_error_t disassemble_section_parallel(output_t* out, thread_pool_t* pool, cs_arch arch, cs_mode mode,
+                                          uint32_t flags, const char* section_name, const uint8_t* code,
+                                          size_t size, uint64_t address, const symbol_index_t* symbols);
+macho_error_t disassemble_code_sections(output_t* out, const macho_ctx_t* ctx, cs_arch arch, cs_mode mode,
+                                       uint32_t flags, uint64_t start, uint64_t stop, uint32_t nthreads);
+const disasm_arch_t* find_disasm_arch(cpu_type_t cputype);
+macho_error_t find_symbol_range(const macho_ctx_t* ctx, const char* name, uint64_t* start, uint64_t* stop);
+macho_error_t disassemble_macho(output_t* out, const macho_ctx_t* ctx, const disasm_options_t* opts);
 
-#endif // LOAD_COMMANDS_H
 
+#endif // DISASM_H
@@ -0,0 +1,98 @@
+/*
+* dyldinfo.h
+* Coded by iosmen (c) 2025
+*/
+#ifndef DYLDINFO_H
+#define DYLDINFO_H
+
+#include "utils.h"
+#include "output.h"
+#include <stdint.h>
+
+// Longest exported name the trie walk builds, longer names mark a malformed trie
+#define EXPORT_NAME_MAX 4096
+
+// Opcode streams of LC_DYLD_INFO(_ONLY)
+typedef enum {
+    DYLD_INFO_REBASE = 0,
+    DYLD_INFO_BIND,
+    DYLD_INFO_WEAK_BIND,
+    DYLD_INFO_LAZY_BIND
+} dyld_info_kind_t;
+
+// One rebase or bind produced by the opcode interpreter
+typedef struct {
+    dyld_info_kind_t kind;
+    uint64_t address;           // vmaddr of the pointer
+    uint64_t segment_offset;
+    uint32_t segment;
+    uint8_t type;               // REBASE_TYPE_* / BIND_TYPE_*
+    uint8_t flags;              // BIND_SYMBOL_FLAGS_*
+    int32_t lib_ordinal;
+    int64_t addend;
+    const char* symbol;         // Binds, points into the opcode stream
+    const char* dylib;          // Binds, library the ordinal refers to
+} dyld_info_record_t;
+
+// Pull decoder over one opcode stream, records are produced one at a time so a
+// consumer can stop early without the table ever being materialized
+typedef struct {
+    dyld_info_kind_t kind;
+    const uint8_t* p;
+    const uint8_t* end;
+    uint32_t pointer_size;
+    const segment_info_t* segments;
+    uint32_t nsegments;
+    char** dylibs;              // Owned
+    uint32_t ndylibs;
+    
+    // Interpreter state
+    uint32_t segment;
+    uint64_t offset;
+    uint8_t type;
+    uint8_t flags;
+    int32_t lib_ordinal;
+    int64_t addend;
+    const char* symbol;
+    uint64_t pending;           // Records left from the current DO_* opcode
+    uint64_t step;              // Address increment after each of them
+    int done;
+    macho_error_t err;
+} dyld_info_iter_t;
+
+// One exported symbol found by the trie walker
+typedef struct {
+    const char* name;           // Valid during the callback only
+    uint64_t flags;             // EXPORT_SYMBOL_FLAGS_*
+    uint64_t address;           // vmaddr, or the raw value for absolute symbols
+    uint64_t resolver;          // Stub-and-resolver exports
+    uint64_t reexport_ordinal;  // Re-exports
+    const char* import_name;    // Re-exports under another name, empty when unchanged
+} export_entry_t;
+
+// Called for every export, a non-zero return stops the walk
+typedef int (*export_fn)(const export_entry_t* entry, void* arg);
+
+// Every export flattened and sorted by name, for bulk dumps
+typedef struct {
+    export_entry_t* entries;
+    uint32_t count;
+    char* names;                // Arena the entry names point into
+} export_list_t;
+
+// Function prototypes
+macho_error_t dyld_info_iter_init(dyld_info_iter_t* iter, const macho_ctx_t* ctx, dyld_info_kind_t kind);
+int dyld_info_iter_next(dyld_info_iter_t* iter, dyld_info_record_t* record);
+void dyld_info_iter_free(dyld_info_iter_t* iter);
+macho_error_t find_export_trie(const macho_ctx_t* ctx, const uint8_t** trie, uint32_t* size);
+macho_error_t walk_export_trie(const macho_ctx_t* ctx, export_fn fn, void* arg);
+macho_error_t walk_export_prefix(const macho_ctx_t* ctx, const char* prefix, export_fn fn, void* arg);
+macho_error_t find_export(const macho_ctx_t* ctx, const char* name, export_entry_t* entry, int* found);
+macho_error_t build_export_list(const macho_ctx_t* ctx, export_list_t* list);
+void free_export_list(export_list_t* list);
+void print_exports(output_t* out, const macho_ctx_t* ctx);
+void print_export_list(output_t* out, const macho_ctx_t* ctx, const char* prefix);
+void print_export_lookups(output_t* out, const macho_ctx_t* ctx, char* const* names, uint32_t count);
+void print_dyld_info(output_t* out, const macho_ctx_t* ctx);
+
+#endif // DYLDINFO_H
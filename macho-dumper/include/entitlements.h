@@ -6,23 +6,35 @@
 #define ENTITLEMENTS_H
 
 #include "utils.h"
+#include "output.h"
+#include "plist.h"
 #include "macho.h"
 
-// Entitlements structure
+// Entries printed before the listing is cut short, shared plist objects can fan out
+#define ENTITLEMENTS_MAX_PRINTED 4096
+
+// Entitlements structure, key and value live in the parsed plist
 typedef struct entitlement {
-    char* key;
-    char* value;
+    const char* key;
+    const plist_node_t* value;
     struct entitlement* next;
 } entitlement_t;
 
 typedef struct {
     entitlement_t* head;
     uint32_t count;
+    const char* data;       // Raw blob payload, points into the image
+    uint32_t offset;
+    uint32_t size;
+    const char* format;     // "der", "xml" or "binary"
+    const char* error;      // Payload is not a property list dictionary, only data is set
+    plist_t plist;
 } entitlements_t;
 
 // Function prototypes
 macho_error_t parse_entitlements(const macho_ctx_t* ctx, entitlements_t** entitlements);
-void print_entitlements(const entitlements_t* entitlements);
+const plist_node_t* find_entitlement(const entitlements_t* entitlements, const char* key);
+void print_entitlements(output_t* out, const entitlements_t* entitlements);
 void free_entitlements(entitlements_t* entitlements);
 
 #endif // ENTITLEMENTS_H
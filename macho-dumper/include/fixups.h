@@ -0,0 +1,81 @@
+/*
+* fixups.h
+* Coded by iosmen (c) 2025
+*/
+#ifndef FIXUPS_H
+#define FIXUPS_H
+
+#include "utils.h"
+#include "output.h"
+#include <stdint.h>
+
+// Pointer formats of dyld_chained_starts_in_segment (mach-o/fixup-chains.h)
+#define DYLD_CHAINED_PTR_ARM64E             1
+#define DYLD_CHAINED_PTR_64                 2
+#define DYLD_CHAINED_PTR_32                 3
+#define DYLD_CHAINED_PTR_32_CACHE           4
+#define DYLD_CHAINED_PTR_32_FIRMWARE        5
+#define DYLD_CHAINED_PTR_64_OFFSET          6
+#define DYLD_CHAINED_PTR_ARM64E_KERNEL      7
+#define DYLD_CHAINED_PTR_64_KERNEL_CACHE    8
+#define DYLD_CHAINED_PTR_ARM64E_USERLAND    9
+#define DYLD_CHAINED_PTR_ARM64E_FIRMWARE    10
+#define DYLD_CHAINED_PTR_X86_64_KERNEL_CACHE 11
+#define DYLD_CHAINED_PTR_ARM64E_USERLAND24  12
+
+// Import table formats
+#define DYLD_CHAINED_IMPORT                 1
+#define DYLD_CHAINED_IMPORT_ADDEND          2
+#define DYLD_CHAINED_IMPORT_ADDEND64        3
+
+#define DYLD_CHAINED_PTR_START_NONE         0xFFFF
+#define DYLD_CHAINED_PTR_START_MULTI        0x8000
+#define DYLD_CHAINED_PTR_START_LAST         0x8000
+
+// Validated view of the LC_DYLD_CHAINED_FIXUPS payload, tables point into the image
+typedef struct {
+    const uint8_t* data;
+    uint32_t size;
+    uint32_t version;
+    uint32_t starts_offset;     // dyld_chained_starts_in_image
+    uint32_t seg_count;
+    uint32_t imports_offset;
+    uint32_t imports_count;
+    uint32_t imports_format;    // DYLD_CHAINED_IMPORT*
+    uint32_t symbols_offset;
+    uint32_t symbols_format;    // 0 plain, 1 zlib (names are not decoded)
+    uint64_t image_base;        // vmaddr of the segment mapping file offset 0
+    char** dylibs;              // Owned, bind ordinals are 1-based indices
+    uint32_t ndylibs;
+} chained_fixups_t;
+
+// One decoded pointer of a chain
+typedef struct {
+    uint64_t address;           // vmaddr of the pointer
+    uint64_t target;            // Rebase target vmaddr
+    int64_t addend;             // Bind addend
+    const char* symbol;         // Bind target name, NULL when unavailable
+    const char* dylib;          // Library the bind resolves against
+    int32_t lib_ordinal;
+    uint32_t segment;           // Segment index in load command order
+    uint16_t pointer_format;
+    uint16_t diversity;         // Pointer authentication
+    uint8_t is_bind;
+    uint8_t is_auth;
+    uint8_t is_weak;
+    uint8_t key;
+    uint8_t addr_div;
+} chained_fixup_t;
+
+// Called for every fixup in chain order, a non-zero return stops the walk
+typedef int (*chained_fixup_fn)(const chained_fixup_t* fixup, void* arg);
+
+// Function prototypes
+macho_error_t parse_chained_fixups(const macho_ctx_t* ctx, chained_fixups_t* fixups);
+void free_chained_fixups(chained_fixups_t* fixups);
+int chained_fixups_has_segment(const chained_fixups_t* fixups, uint32_t segment);
+macho_error_t walk_chained_fixups(const macho_ctx_t* ctx, const chained_fixups_t* fixups, uint32_t segment,
+                                  chained_fixup_fn fn, void* arg, uint64_t* count);
+macho_error_t print_chained_fixups(output_t* out, const macho_ctx_t* ctx, uint32_t nthreads);
+
+#endif // FIXUPS_H
@@ -6,6 +6,7 @@
 #define LOAD_COMMANDS_H
 
 #include "utils.h"
+#include "output.h"
 #include <mach-o/loader.h>
 #include <stdint.h>
 
@@ -18,13 +19,6 @@
 typedef int vm_prot_t;
 #endif
 
-// Load command types
-typedef struct {
-    uint32_t cmd;
-    uint32_t cmdsize;
-    void* data;
-} load_command_t;
-
 // Segment and section information
 typedef struct {
     char segname[16];
@@ -53,8 +47,14 @@ typedef struct {
 
 // Function prototypes
 macho_error_t parse_load_commands(macho_ctx_t* ctx);
-void print_load_commands(const macho_ctx_t* ctx);
-macho_error_t parse_segment_commands(macho_ctx_t* ctx, segment_info_t** segments, uint32_t* nsegments);
+void free_load_commands(macho_ctx_t* ctx);
+macho_error_t find_linkedit_data(const macho_ctx_t* ctx, uint32_t cmd, uint32_t* dataoff, uint32_t* datasize);
+void print_load_commands(output_t* out, const macho_ctx_t* ctx);
+macho_error_t parse_segment_commands(const macho_ctx_t* ctx, segment_info_t** segments, uint32_t* nsegments);
 void free_segments(segment_info_t* segments, uint32_t nsegments);
+macho_error_t get_segments(const macho_ctx_t* ctx, const segment_info_t** segments, uint32_t* nsegments);
+const segment_info_t* find_segment(const macho_ctx_t* ctx, const char* segname);
+const section_info_t* find_section(const macho_ctx_t* ctx, const char* segname, const char* sectname);
+uint64_t get_image_base(const macho_ctx_t* ctx);
 
 #endif // LOAD_COMMANDS_H
@@ -7,13 +7,72 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <pthread.h>
 #include <mach-o/loader.h>
 #include <mach-o/fat.h>
 
-// Mach-O context structure
+// Architecture slice of a Mach-O or FAT file
 typedef struct {
-    void* data;
+    cpu_type_t cputype;
+    cpu_subtype_t cpusubtype;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t align;
+} macho_arch_t;
+
+// File image shared by every slice context
+typedef struct {
+    void* data;             // Read-only file image (mapped when is_mapped is set)
     size_t size;
+    int is_mapped;
+    int is_fat;
+    macho_arch_t* archs;    // One entry per slice, a thin file has exactly one
+    uint32_t narchs;
+} macho_file_t;
+
+// Load command view, cmd/cmdsize are already byte-swapped and data points into the image
+typedef struct {
+    uint32_t cmd;
+    uint32_t cmdsize;
+    uint32_t offset;        // Offset of the command within the thin image
+    void* data;
+} load_command_t;
+
+// Per-type lookup tables, filled in the same pass as the load command table.
+// Buckets hold indices into load_commands, single commands point at their entry.
+typedef struct {
+    uint32_t* segments;     // LC_SEGMENT / LC_SEGMENT_64
+    uint32_t nsegments;
+    uint32_t* dylibs;       // LC_LOAD_DYLIB, weak, reexport, lazy and upward dylibs
+    uint32_t ndylibs;
+    uint32_t* rpaths;       // LC_RPATH
+    uint32_t nrpaths;
+    uint32_t* linkedit;     // Every linkedit_data_command
+    uint32_t nlinkedit;
+    const load_command_t* symtab;
+    const load_command_t* dysymtab;
+    const load_command_t* dyld_info;        // LC_DYLD_INFO or LC_DYLD_INFO_ONLY
+    const load_command_t* build_version;
+    const load_command_t* code_signature;
+    const load_command_t* chained_fixups;
+    const load_command_t* exports_trie;
+    const load_command_t* function_starts;
+    const load_command_t* id_dylib;
+    const load_command_t* entry_point;      // LC_MAIN
+    const load_command_t* uuid;
+} load_command_index_t;
+
+// Lazily built analysis state, defined below once the module types are known
+typedef struct macho_cache macho_cache_t;
+
+// Mach-O context structure
+typedef struct {
+    void* data;             // Start of the thin image (slice view into file->data)
+    size_t size;            // Size of the thin image
+    const macho_file_t* file;
+    macho_file_t* owned_file; // Set when parse_macho() opened the file itself
+    uint32_t arch_index;
+    uint64_t base_offset;   // Offset of the thin image within file->data
     int is_64bit;
     int is_swap;
     int is_fat;
@@ -23,20 +82,58 @@ typedef struct {
     uint32_t ncmds;
     uint32_t sizeofcmds;
     uint32_t flags;
-    struct load_command** load_commands;
+    load_command_t* load_commands;  // Flat table, one allocation for all commands
+    uint32_t nload_commands;        // Parsed entries, less than ncmds if truncated
+    load_command_index_t lc_index;
+    macho_cache_t* cache;           // Owned, safe to fill from const contexts and threads
 } macho_ctx_t;
 
 #include "utils.h"
+#include "digest.h"
+#include "plist.h"
+#include "output.h"
 #include "load_commands.h"
+#include "symbols.h"
 #include "disasm.h"
+#include "fixups.h"
+#include "dyldinfo.h"
 #include "csblob.h"
 #include "swift.h"
 #include "entitlements.h"
 #include "tree.h"
+#include "threadpool.h"
+#include "batch.h"
+
+struct macho_cache {
+    pthread_mutex_t lock;
+    
+    // Segment model, built on first use by get_segments()
+    int segments_built;
+    macho_error_t segments_err;
+    segment_info_t* segments;
+    uint32_t nsegments;
+    const section_info_t** section_table;   // Open addressing, keyed by segname,sectname
+    uint32_t section_table_size;            // Power of two
+    
+    // Symbol index, built on first use by get_symbol_index()
+    int symbols_built;
+    macho_error_t symbols_err;
+    symbol_index_t symbols;
+    
+    // SuperBlob index, built on first use by get_code_signature()
+    int signature_built;
+    macho_error_t signature_err;
+    cs_signature_t signature;
+};
 
 // Function prototypes
+macho_error_t open_macho_file(macho_file_t* file, const char* filename);
+void close_macho_file(macho_file_t* file);
+int find_macho_arch(const macho_file_t* file, const char* name);
+const char* get_arch_name(cpu_type_t cputype, cpu_subtype_t cpusubtype);
+macho_error_t parse_macho_slice(macho_ctx_t* ctx, const macho_file_t* file, uint32_t index);
 macho_error_t parse_macho(macho_ctx_t* ctx, const char* filename);
-void print_header_info(const macho_ctx_t* ctx);
+void print_header_info(output_t* out, const macho_ctx_t* ctx);
 void free_macho_context(macho_ctx_t* ctx);
 macho_error_t parse_fat_binary(macho_ctx_t* ctx, const char* filename);
 
@@ -0,0 +1,90 @@
+/*
+* output.h
+* Coded by iosmen (c) 2025
+*/
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include "utils.h"
+#include <stdio.h>
+
+typedef enum {
+    OUTPUT_TEXT = 0,
+    OUTPUT_JSON,
+    OUTPUT_NDJSON
+} output_format_t;
+
+typedef enum {
+    OUTPUT_STR = 0,
+    OUTPUT_UINT,
+    OUTPUT_HEX,
+    OUTPUT_BOOL
+} output_type_t;
+
+// Bytes buffered before a stream-backed sink writes them out
+#define OUTPUT_BUFFER_SIZE (64 * 1024)
+#define OUTPUT_MAX_DEPTH 16
+#define OUTPUT_MAX_CONTEXT 4
+
+typedef struct output output_t;
+
+// One set of callbacks per format. Every field carries a JSON key and a text label:
+// text skips fields without a label, JSON drops the key inside arrays. NDJSON turns
+// each top-level object and each element of a top-level or stream array into its own
+// record, typed by the element key (or the array key) and tagged with the context.
+typedef struct {
+    void (*begin_object)(output_t* out, const char* key, const char* label, int inline_object);
+    void (*end_object)(output_t* out);
+    void (*begin_array)(output_t* out, const char* key, const char* label, uint64_t count);
+    void (*end_array)(output_t* out);
+    void (*begin_stream)(output_t* out, const char* key, const char* label, uint64_t count);
+    void (*field)(output_t* out, const char* key, const char* label, output_type_t type,
+                  const char* str, size_t len, uint64_t num);
+    void (*insn)(output_t* out, uint64_t address, const uint8_t* bytes, size_t size,
+                 const char* mnemonic, const char* op_str, const char* symbol);
+} output_formatter_t;
+
+struct output {
+    FILE* stream;                           // NULL keeps everything in memory (per-thread fragments)
+    output_format_t format;
+    const output_formatter_t* formatter;
+    strbuf_t buf;
+    uint32_t depth;
+    uint32_t indent;                        // Text indentation level
+    uint8_t has_items[OUTPUT_MAX_DEPTH];    // JSON: a separator is needed before the next value
+    uint8_t is_array[OUTPUT_MAX_DEPTH];
+    uint8_t flags[OUTPUT_MAX_DEPTH];        // Text: inline / indented level, NDJSON: level kind
+    const char* types[OUTPUT_MAX_DEPTH];    // NDJSON: record type of a record or stream level
+    const char* context_keys[OUTPUT_MAX_CONTEXT];
+    const char* context_values[OUTPUT_MAX_CONTEXT];
+    uint32_t ncontext;
+};
+
+// Function prototypes
+void output_init(output_t* out, FILE* stream, output_format_t format);
+void output_init_fragment(output_t* out, const output_t* parent, int continues);
+void output_append(output_t* out, const output_t* fragment);
+void output_flush(output_t* out);
+void output_free(output_t* out);
+int output_format_from_name(const char* name, output_format_t* format);
+
+void output_write(output_t* out, const char* data, size_t len);
+void output_text(output_t* out, const char* text);
+
+void output_begin_object(output_t* out, const char* key, const char* label);
+void output_begin_inline(output_t* out, const char* key, const char* label);
+void output_end_object(output_t* out);
+void output_begin_array(output_t* out, const char* key, const char* label, uint64_t count);
+void output_end_array(output_t* out);
+void output_begin_stream(output_t* out, const char* key, const char* label, uint64_t count);
+void output_context(output_t* out, const char* key, const char* value);
+
+void output_str(output_t* out, const char* key, const char* label, const char* value);
+void output_strn(output_t* out, const char* key, const char* label, const char* value, size_t len);
+void output_uint(output_t* out, const char* key, const char* label, uint64_t value);
+void output_hex(output_t* out, const char* key, const char* label, uint64_t value);
+void output_bool(output_t* out, const char* key, const char* label, int value);
+void output_insn(output_t* out, uint64_t address, const uint8_t* bytes, size_t size,
+                 const char* mnemonic, const char* op_str, const char* symbol);
+
+#endif // OUTPUT_H
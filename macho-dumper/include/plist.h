@@ -0,0 +1,55 @@
+/*
+* plist.h
+* Coded by iosmen (c) 2025
+*/
+#ifndef PLIST_H
+#define PLIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "utils.h"
+
+// Deepest nesting the parsers accept, hostile input cannot exhaust the stack
+#define PLIST_MAX_DEPTH 64
+
+typedef enum {
+    PLIST_STRING = 0,
+    PLIST_BOOL,
+    PLIST_INTEGER,
+    PLIST_REAL,
+    PLIST_DATE,
+    PLIST_DATA,
+    PLIST_ARRAY,
+    PLIST_DICT
+} plist_type_t;
+
+// Parsed value, everything it points to lives in the plist arena or the input
+typedef struct plist_node {
+    plist_type_t type;
+    const char* string;             // STRING and DATE (XML), NUL terminated
+    const uint8_t* data;            // DATA payload
+    uint32_t length;                // Bytes of string or data
+    int64_t integer;                // INTEGER, and BOOL as 0 or 1
+    double real;                    // REAL, and DATE from a binary plist
+    struct plist_node** items;      // ARRAY elements, DICT values
+    const char** keys;              // DICT keys, parallel to items
+    uint32_t count;
+} plist_node_t;
+
+// A parsed document, one arena sized from the input holds every node and string
+typedef struct {
+    plist_node_t* root;
+    uint8_t* arena;
+    size_t arena_size;
+    size_t used;                    // Nodes and strings grow up from the start
+    size_t top;                     // Scratch stack grows down from the end
+} plist_t;
+
+// Function prototypes
+macho_error_t plist_parse(const void* data, size_t size, plist_t* plist);
+macho_error_t plist_parse_der(const void* data, size_t size, plist_t* plist);
+void plist_free(plist_t* plist);
+const plist_node_t* plist_dict_get(const plist_node_t* dict, const char* key);
+const char* plist_type_name(plist_type_t type);
+
+#endif // PLIST_H
@@ -0,0 +1,46 @@
+/*
+* symbols.h
+* Coded by iosmen (c) 2025
+*/
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include "utils.h"
+#include "output.h"
+#include <mach-o/nlist.h>
+
+#ifndef N_NO_DEAD_STRIP
+#define N_NO_DEAD_STRIP 0x0020
+#endif
+
+// Defined symbols of LC_SYMTAB as parallel arrays sorted by address. Names are not
+// copied, strx points into the string table which stays in the mapped image.
+typedef struct {
+    uint32_t count;
+    uint64_t* addresses;        // Ascending, binary searched
+    uint32_t* strx;             // Name offset in the string table
+    uint8_t* types;             // n_type
+    uint8_t* sects;             // n_sect, 1-based section ordinal
+    uint16_t* descs;            // n_desc (weak, Thumb, ...)
+    const char* strtab;
+    uint32_t strsize;           // Trimmed so every name is NUL terminated
+    uint32_t nsyms;             // All LC_SYMTAB entries, including undefined and stabs
+    uint32_t* name_lengths;     // strlen of each name, names are (strx, length) pairs
+    uint32_t* name_table;       // Open addressing over names, symbol index + 1, 0 is empty
+    uint32_t name_table_size;   // Power of two
+} symbol_index_t;
+
+// Function prototypes
+macho_error_t build_symbol_index(const macho_ctx_t* ctx, symbol_index_t* index);
+void free_symbol_index(symbol_index_t* index);
+macho_error_t get_symbol_index(const macho_ctx_t* ctx, const symbol_index_t** index);
+const char* symbol_name(const symbol_index_t* index, uint32_t i);
+uint32_t symbol_lower_bound(const symbol_index_t* index, uint64_t address);
+int find_symbol_by_address(const macho_ctx_t* ctx, const symbol_index_t* index, uint64_t address, uint32_t* i);
+int find_symbol_by_name(const symbol_index_t* index, const char* name, uint32_t* i);
+int find_symbol_by_name_len(const symbol_index_t* index, const char* name, size_t len, uint32_t* i);
+const section_info_t* section_for_ordinal(const macho_ctx_t* ctx, uint8_t ordinal);
+void print_symbol_lookups(output_t* out, const macho_ctx_t* ctx, char* const* names, uint32_t count);
+void print_address_symbols(output_t* out, const macho_ctx_t* ctx, const uint64_t* addresses, uint32_t count);
+
+#endif // SYMBOLS_H
@@ -0,0 +1,26 @@
+/*
+* threadpool.h
+* Coded by iosmen (c) 2025
+*/
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include "utils.h"
+#include <stdint.h>
+
+typedef void (*pool_task_fn)(void* arg);
+
+// Work-stealing pool: one deque per worker, idle workers steal from the others.
+// At most max_pending tasks are queued, submit() blocks callers outside the pool
+// once that limit is hit so producers cannot outrun the workers.
+typedef struct thread_pool thread_pool_t;
+
+// Function prototypes
+thread_pool_t* thread_pool_create(uint32_t nthreads, uint32_t max_pending);
+macho_error_t thread_pool_submit(thread_pool_t* pool, pool_task_fn fn, void* arg);
+void thread_pool_wait(thread_pool_t* pool);
+void thread_pool_destroy(thread_pool_t* pool);
+uint32_t thread_pool_size(const thread_pool_t* pool);
+uint32_t thread_pool_default_threads(void);
+
+#endif // THREADPOOL_H
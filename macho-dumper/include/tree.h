@@ -8,22 +8,71 @@
 #include "utils.h"
 #include "macho.h"
 
-// Dependency tree node
+// Dependency graph node, one per resolved image and shared by every image that loads it
 typedef struct dylib_node {
-    char* name;
-    char* path;
+    char* name;                     // Install name of the first load command that reached it
+    char* path;                     // Resolved file, NULL when no candidate exists
     uint32_t timestamp;
     uint32_t current_version;
     uint32_t compatibility_version;
     struct dylib_node** dependencies;
     uint32_t dep_count;
+    char** rpaths;                  // LC_RPATH entries as written, expanded when searched
+    uint32_t nrpaths;
+    struct dylib_node* loader;      // First image that loaded it, its load chain for @rpath
+    uint32_t id;                    // Index in dylib_graph_t.nodes
+    int is_stub;                    // Resolved to a .tbd stub in the SDK root, not parsed
+    macho_error_t status;
+    
+    // Identity of the parsed slice, used to find duplicate copies of an image
+    char* install_name;             // LC_ID_DYLIB, NULL for executables
+    uint8_t uuid[16];
+    int has_uuid;
+    
+    // Filled by the graph analysis once the closure is loaded
+    uint64_t size;                  // Slice size
+    uint64_t weight;                // Size of the image and everything it loads, each image counted once
+    uint32_t cycle;                 // 1-based dependency cycle the image is part of, 0 when none
+    struct dylib_node* duplicate_of;    // Earlier image with the same UUID or install name
+    uint32_t duplicate_loads;       // Load commands naming an image this one already loads
 } dylib_node_t;
 
+// Every image of a closure, the root first. The path cache makes sure each file is parsed once.
+typedef struct {
+    dylib_node_t** nodes;
+    uint32_t count;
+    uint32_t cap;
+    dylib_node_t** table;           // Open addressing, keyed by path (install name if unresolved)
+    uint32_t table_size;            // Power of two
+    uint32_t ncycles;
+    uint32_t nduplicates;
+} dylib_graph_t;
+
+// Standalone dependency graph exports
+typedef enum {
+    DEP_GRAPH_NONE = 0,
+    DEP_GRAPH_DOT,
+    DEP_GRAPH_JSON,
+    DEP_GRAPH_EDGES
+} dep_graph_format_t;
+
+// Dependency resolution options
+typedef struct {
+    const char* sdk_root;           // Tried first for absolute install names and rpaths
+    const char* executable_path;    // Main executable for @executable_path, defaults to the root
+    uint32_t nthreads;              // Images parsed in parallel, 0 means one per CPU
+} dependency_options_t;
+
 // Function prototypes
-macho_error_t build_dependency_tree(const macho_ctx_t* ctx, dylib_node_t** root);
-void print_dependency_tree(const dylib_node_t* node, int depth);
-void free_dependency_tree(dylib_node_t* node);
+macho_error_t build_dependency_tree(const macho_ctx_t* ctx, const char* path, const dependency_options_t* opts,
+                                    dylib_graph_t* graph);
+void print_dependency_tree(output_t* out, const dylib_graph_t* graph);
+void print_dependency_dot(output_t* out, const dylib_graph_t* graph);
+void print_dependency_edges(output_t* out, const dylib_graph_t* graph);
+int dep_graph_format_from_name(const char* name, dep_graph_format_t* format);
+void free_dependency_tree(dylib_graph_t* graph);
 macho_error_t find_dylib_dependencies(const macho_ctx_t* ctx, char*** dylibs, uint32_t* count);
+const char* get_dylib_ordinal_name(char* const* dylibs, uint32_t count, int32_t ordinal);
 
 
 #endif // TREE_H
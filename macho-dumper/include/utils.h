@@ -23,15 +23,40 @@ typedef enum {
     ERROR_DISASM_FAILED
 } macho_error_t;
 
+// Paging hints for mapped file regions
+typedef enum {
+    ADVISE_NORMAL = 0,
+    ADVISE_WILLNEED,
+    ADVISE_RANDOM,
+    ADVISE_SEQUENTIAL
+} file_advice_t;
+
+// Growable output buffer, data is always NUL terminated once written
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} strbuf_t;
+
 void* read_file(const char* filename, size_t* size);
 void free_file(void* data);
+void* map_file(const char* filename, size_t* size);
+void unmap_file(void* data, size_t size);
+void advise_file_range(const void* base, size_t size, uint64_t offset, uint64_t length, file_advice_t advice);
 int validate_magic(uint32_t magic);
 
 uint32_t swap32(uint32_t value);
 uint64_t swap64(uint64_t value);
 
+const char* get_cpu_type_name(cpu_type_t cputype);
+const char* get_file_type_name(uint32_t filetype);
+
 const char* macho_strerror(macho_error_t error);
 
+void strbuf_init(strbuf_t* buf);
+void strbuf_append(strbuf_t* buf, const char* str, size_t len);
+void strbuf_free(strbuf_t* buf);
+
 #ifdef DEBUG
 #define debug_print(fmt, ...) printf(fmt, ##__VA_ARGS__)
 #else
@@ -0,0 +1,273 @@
+/*
+* batch.c
+* Coded by iosmen (c) 2025
+*/
+#include "../include/batch.h"
+#include "../include/threadpool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <pthread.h>
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+// Bytes of a summary line beyond its path: arch, file type, counts, signature and cdhash
+#define SLICE_LINE_EXTRA 256
+
+// Shared state of one batch run
+typedef struct {
+    thread_pool_t* pool;
+    const batch_options_t* opts;
+    pthread_mutex_t lock;
+    batch_stats_t stats;
+} batch_t;
+
+typedef struct {
+    batch_t* batch;
+    char* path;
+} batch_job_t;
+
+// Check the magic without mapping the file
+int is_macho_file(const char* path) {
+    if (!path) return 0;
+    
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) return 0;
+    
+    uint32_t magic = 0;
+    ssize_t bytes_read = read(fd, &magic, sizeof(magic));
+    close(fd);
+    
+    return bytes_read == sizeof(magic) && validate_magic(magic);
+}
+
+// Append one summary line for a parsed slice, returns 0 when verification failed
+static int append_slice_summary(char* line, size_t line_size, const char* path, const macho_ctx_t* ctx, const batch_options_t* opts) {
+    const char* signature = ctx->lc_index.code_signature ? "signed" : "unsigned";
+    int valid = 1;
+    
+    // Files are already spread over the pool, so each one is hashed on its worker
+    if (opts->verify && ctx->lc_index.code_signature) {
+        cs_verify_t* results = NULL;
+        uint32_t count = 0;
+        valid = verify_code_signature(ctx, 1, &results, &count) == SUCCESS &&
+                code_signature_valid(results, count);
+        free(results);
+        signature = valid ? "signature valid" : "signature INVALID";
+    }
+    
+    // Computed from the mapped signature, keys a database without re-reading the file
+    char cdhash_str[CS_CDHASH_LEN * 2 + 16] = "";
+    uint8_t cdhash[CS_CDHASH_LEN];
+    if (opts->cdhash && compute_cdhash(ctx, cdhash, NULL) == SUCCESS) {
+        memcpy(cdhash_str, ", cdhash ", 9);
+        format_cdhash(cdhash, cdhash_str + 9);
+    }
+    
+    size_t len = strlen(line);
+    snprintf(line + len, line_size - len, "  %s (%s): %s, %u load commands, %u dylibs, %s%s\n",
+             path, get_arch_name(ctx->cputype, ctx->cpusubtype), get_file_type_name(ctx->filetype),
+             ctx->ncmds, ctx->lc_index.ndylibs, signature, cdhash_str);
+    return valid;
+}
+
+// Worker task: detect, parse and summarize one file
+static void scan_file_task(void* arg) {
+    batch_job_t* job = (batch_job_t*)arg;
+    batch_t* batch = job->batch;
+    const batch_options_t* opts = batch->opts;
+    uint32_t machos = 0, slices = 0, errors = 0, invalid = 0;
+    char* line = NULL;
+    
+    if (is_macho_file(job->path)) {
+        machos = 1;
+        
+        // One line per slice, every line fits however long the path is
+        macho_file_t file;
+        macho_error_t err = open_macho_file(&file, job->path);
+        size_t line_size = (size_t)(err == SUCCESS && file.narchs > 0 ? file.narchs : 1) *
+                           (strlen(job->path) + SLICE_LINE_EXTRA);
+        line = calloc(1, line_size);
+        if (!line) {
+            errors++;
+            if (err == SUCCESS) close_macho_file(&file);
+        } else if (err != SUCCESS) {
+            snprintf(line, line_size, "  %s: Error: %s\n", job->path, macho_strerror(err));
+            errors++;
+        } else {
+            for (uint32_t i = 0; i < file.narchs; i++) {
+                const char* name = get_arch_name(file.archs[i].cputype, file.archs[i].cpusubtype);
+                if (opts->arch_name && strcmp(name, opts->arch_name) != 0) continue;
+                if (!opts->arch_name && !opts->all_archs && i > 0) break;
+                
+                macho_ctx_t ctx;
+                err = parse_macho_slice(&ctx, &file, i);
+                if (err == SUCCESS) {
+                    if (!append_slice_summary(line, line_size, job->path, &ctx, opts)) {
+                        invalid++;
+                    }
+                    slices++;
+                } else {
+                    size_t len = strlen(line);
+                    snprintf(line + len, line_size - len, "  %s (%s): Error: %s\n",
+                             job->path, name, macho_strerror(err));
+                    errors++;
+                }
+                free_macho_context(&ctx);
+            }
+            close_macho_file(&file);
+        }
+    }
+    
+    // One write per file keeps lines from different workers intact
+    if (line && line[0]) {
+        flockfile(stdout);
+        fputs(line, stdout);
+        funlockfile(stdout);
+    }
+    free(line);
+    
+    pthread_mutex_lock(&batch->lock);
+    batch->stats.files++;
+    batch->stats.machos += machos;
+    batch->stats.slices += slices;
+    batch->stats.errors += errors;
+    batch->stats.invalid += invalid;
+    pthread_mutex_unlock(&batch->lock);
+    
+    free(job->path);
+    free(job);
+}
+
+// A path the walker could not scan, counted with the parse errors
+static void report_path_error(batch_t* batch, const char* path, macho_error_t err) {
+    flockfile(stdout);
+    printf("  %s: Error: %s\n", path, macho_strerror(err));
+    funlockfile(stdout);
+    
+    pthread_mutex_lock(&batch->lock);
+    batch->stats.errors++;
+    pthread_mutex_unlock(&batch->lock);
+}
+
+static void submit_file(batch_t* batch, const char* path) {
+    batch_job_t* job = calloc(1, sizeof(batch_job_t));
+    if (!job) {
+        report_path_error(batch, path, ERROR_READ_FAILED);
+        return;
+    }
+    
+    job->batch = batch;
+    job->path = strdup(path);
+    if (!job->path || thread_pool_submit(batch->pool, scan_file_task, job) != SUCCESS) {
+        free(job->path);
+        free(job);
+        report_path_error(batch, path, ERROR_READ_FAILED);
+    }
+}
+
+// Walk a file or directory tree (.app and .framework bundles included). Named inputs
+// follow symlinks, inside a directory they are skipped so Versions/Current in framework
+// bundles is not scanned twice.
+static void walk_path(batch_t* batch, const char* path, int named) {
+    struct stat st;
+    if ((named ? stat(path, &st) : lstat(path, &st)) == -1) {
+        report_path_error(batch, path, ERROR_FILE_NOT_FOUND);
+        return;
+    }
+    if (S_ISLNK(st.st_mode)) return;
+    
+    if (S_ISREG(st.st_mode)) {
+        if (named && access(path, R_OK) == -1) {
+            report_path_error(batch, path, ERROR_FILE_NOT_FOUND);
+            return;
+        }
+        submit_file(batch, path);
+        return;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        if (named) report_path_error(batch, path, ERROR_READ_FAILED);
+        return;
+    }
+    
+    DIR* dir = opendir(path);
+    if (!dir) {
+        report_path_error(batch, path, ERROR_FILE_NOT_FOUND);
+        return;
+    }
+    
+    struct dirent* entry;
+    char child[PATH_MAX];
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        
+        int len = snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+        if (len < 0 || (size_t)len >= sizeof(child)) {
+            report_path_error(batch, entry->d_name, ERROR_FILE_NOT_FOUND);
+            continue;
+        }
+        walk_path(batch, child, 0);
+    }
+    closedir(dir);
+}
+
+// Walk every path listed one per line in a stream
+static void walk_list(batch_t* batch, FILE* list) {
+    char path[PATH_MAX];
+    while (fgets(path, sizeof(path), list)) {
+        size_t len = strcspn(path, "\r\n");
+        path[len] = '\0';
+        if (len > 0) {
+            walk_path(batch, path, 1);
+        }
+    }
+}
+
+// Scan files, directories, bundles and path lists ("-" is stdin) on a worker pool
+macho_error_t run_batch(const char* const* inputs, uint32_t ninputs, const char* manifest,
+                        const batch_options_t* opts, batch_stats_t* stats) {
+    if (!opts || (!inputs && ninputs > 0)) return ERROR_READ_FAILED;
+    
+    batch_t batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.opts = opts;
+    batch.pool = thread_pool_create(opts->nthreads, opts->max_pending);
+    if (!batch.pool) return ERROR_READ_FAILED;
+    pthread_mutex_init(&batch.lock, NULL);
+    
+    macho_error_t err = SUCCESS;
+    if (manifest) {
+        FILE* list = fopen(manifest, "r");
+        if (list) {
+            walk_list(&batch, list);
+            fclose(list);
+        } else {
+            err = ERROR_FILE_NOT_FOUND;
+        }
+    }
+    
+    for (uint32_t i = 0; i < ninputs; i++) {
+        if (strcmp(inputs[i], "-") == 0) {
+            walk_list(&batch, stdin);
+        } else {
+            walk_path(&batch, inputs[i], 1);
+        }
+    }
+    
+    thread_pool_wait(batch.pool);
+    thread_pool_destroy(batch.pool);
+    pthread_mutex_destroy(&batch.lock);
+    
+    if (stats) {
+        *stats = batch.stats;
+    }
+    return err;
+
+}
@@ -2,16 +2,17 @@
 * csblob.c
 * Coded by iosmen (c) 2025
 */
-#include "../include/csblob.h"
+#include "../include/macho.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include "macho.h"
+#include <stddef.h>
 
-// Code signature magic numbers
-#define CSMAGIC_CODEDIRECTORY 0xfade0c02
-#define CSMAGIC_EMBEDDED_SIGNATURE 0xfade0cc0
-#define CSMAGIC_EMBEDDED_ENTITLEMENTS 0xfade7171
+// CodeDirectory version that added codeLimit64
+#define CS_SUPPORTSCODELIMIT64 0x20300
+
+// Bytes of code hashed by one pool task
+#define CS_VERIFY_CHUNK_SIZE (1024 * 1024)
 
 // Find code signature in Mach-O file
 macho_error_t find_code_signature(const macho_ctx_t* ctx, uint32_t* offset, uint32_t* size) {
@@ -20,129 +21,700 @@ macho_error_t find_code_signature(const macho_ctx_t* ctx, uint32_t* offset, uint
     *offset = 0;
     *size = 0;
     
-    // Search for LC_CODE_SIGNATURE load command
-    for (uint32_t i = 0; i < ctx->ncmds; i++) {
-        struct load_command* lc = ctx->load_commands[i];
-        if (!lc) continue;
+    // LC_CODE_SIGNATURE comes straight from the load command index
+    const load_command_t* lc = ctx->lc_index.code_signature;
+    if (!lc) {
+        return ERROR_NO_CODE_SIGNATURE;
+    }
+    
+    struct linkedit_data_command* cs_cmd = (struct linkedit_data_command*)lc->data;
+    *offset = ctx->is_swap ? swap32(cs_cmd->dataoff) : cs_cmd->dataoff;
+    *size = ctx->is_swap ? swap32(cs_cmd->datasize) : cs_cmd->datasize;
+    
+    if ((uint64_t)*offset + *size > ctx->size) {
+        return ERROR_NO_CODE_SIGNATURE;
+    }
+    
+    return SUCCESS;
+}
+
+// Code signature blobs are big-endian whatever the byte order of the Mach-O
+static uint32_t cs_read32(const void* ptr) {
+    const uint8_t* p = (const uint8_t*)ptr;
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// Big-endian word at offset, 0 when it does not fit in the span
+int cs_span_read32(cs_span_t span, uint32_t offset, uint32_t* value) {
+    if (offset > span.size || span.size - offset < 4) return 0;
+    *value = cs_read32(span.data + offset);
+    return 1;
+}
+
+// Narrow a span, 0 when the range does not fit
+int cs_span_sub(cs_span_t span, uint32_t offset, uint32_t length, cs_span_t* sub) {
+    if (offset > span.size || span.size - offset < length) return 0;
+    sub->data = span.data + offset;
+    sub->size = length;
+    return 1;
+}
+
+// CodeDirectory field, callers check the header size first
+static uint32_t cd_field32(cs_span_t cd, uint32_t offset) {
+    uint32_t value = 0;
+    cs_span_read32(cd, offset, &value);
+    return value;
+}
+
+// Slot 0 or one of the alternates
+static int is_code_directory_slot(uint32_t type) {
+    return type == 0 || (type >= CSSLOT_ALTERNATE_CODEDIRECTORIES &&
+                         type < CSSLOT_ALTERNATE_CODEDIRECTORIES + CSSLOT_ALTERNATE_CODEDIRECTORY_MAX);
+}
+
+// Name of a SuperBlob slot
+static const char* blob_type_name(uint32_t type) {
+    if (type != 0 && is_code_directory_slot(type)) return "Alternate Code Directory";
+    
+    switch (type) {
+        case 0: return "Code Directory";
+        case 1: return "Info Slots";
+        case 2: return "Requirements";
+        case 3: return "Resource Directory";
+        case 4: return "Application Specific";
+        case 5: return "Entitlements";
+        case 6: return "Rep Specific";
+        case 7: return "DER Entitlements";
+        case 8: return "Launch Constraint (Self)";
+        case 9: return "Launch Constraint (Parent)";
+        case 10: return "Launch Constraint (Responsible)";
+        case 11: return "Library Constraint";
+        case CSSLOT_SIGNATURESLOT: return "CMS Signature";
+        case CSSLOT_IDENTIFICATIONSLOT: return "Identification";
+        case CSSLOT_TICKETSLOT: return "Ticket";
+        default: return "Unknown";
+    }
+}
+
+// Hash types in the order the kernel prefers them, 0 for unknown types
+static int hash_type_rank(uint8_t hash_type) {
+    switch (hash_type) {
+        case CS_HASHTYPE_SHA384: return 4;
+        case CS_HASHTYPE_SHA256: return 3;
+        case CS_HASHTYPE_SHA256_TRUNCATED: return 2;
+        case CS_HASHTYPE_SHA1: return 1;
+        default: return 0;
+    }
+}
+
+// Map a CodeDirectory hash type onto a digest and the bytes stored per slot
+static int cs_digest_type(uint8_t hash_type, digest_type_t* digest, uint32_t* hash_size) {
+    switch (hash_type) {
+        case CS_HASHTYPE_SHA1: *digest = DIGEST_SHA1; *hash_size = 20; return 1;
+        case CS_HASHTYPE_SHA256: *digest = DIGEST_SHA256; *hash_size = 32; return 1;
+        case CS_HASHTYPE_SHA256_TRUNCATED: *digest = DIGEST_SHA256; *hash_size = 20; return 1;
+        case CS_HASHTYPE_SHA384: *digest = DIGEST_SHA384; *hash_size = 48; return 1;
+        default: return 0;
+    }
+}
+
+// The cdhash is the digest of the whole CodeDirectory blob in its own hash type
+static int code_directory_hash(cs_span_t cd, uint8_t hash_type, uint8_t* cdhash) {
+    digest_type_t digest;
+    uint32_t hash_size;
+    if (!cs_digest_type(hash_type, &digest, &hash_size)) return 0;
+    
+    uint8_t full[DIGEST_MAX_SIZE];
+    digest_buffer(digest, cd.data, cd.size, full);
+    memcpy(cdhash, full, CS_CDHASH_LEN);
+    return 1;
+}
+
+// Decode the SuperBlob index, every offset is checked here and nowhere else
+static macho_error_t build_code_signature(const macho_ctx_t* ctx, cs_signature_t* signature) {
+    macho_error_t err = find_code_signature(ctx, &signature->offset, &signature->size);
+    if (err != SUCCESS) return err;
+    
+    cs_span_t data = { (const uint8_t*)ctx->data + signature->offset, signature->size };
+    if (!cs_span_read32(data, 0, &signature->magic) ||
+        !cs_span_read32(data, 4, &signature->length) ||
+        !cs_span_read32(data, 8, &signature->count)) {
+        signature->error = "Code signature too small";
+        return ERROR_NO_CODE_SIGNATURE;
+    }
+    if (signature->magic != CSMAGIC_EMBEDDED_SIGNATURE) {
+        signature->error = "Invalid code signature magic";
+        return ERROR_NO_CODE_SIGNATURE;
+    }
+    
+    // Never trust length or count beyond the LC_CODE_SIGNATURE range
+    uint32_t limit = signature->length < signature->size ? signature->length : signature->size;
+    if (limit < sizeof(CS_SuperBlob)) limit = sizeof(CS_SuperBlob);
+    cs_span_sub(data, 0, limit, &signature->superblob);
+    
+    uint32_t max_count = (limit - sizeof(CS_SuperBlob)) / sizeof(CS_BlobIndex);
+    uint32_t count = signature->count < max_count ? signature->count : max_count;
+    if (count) {
+        signature->blobs = calloc(count, sizeof(cs_blob_t));
+        if (!signature->blobs) return ERROR_READ_FAILED;
+    }
+    
+    for (uint32_t i = 0; i < count; i++) {
+        cs_blob_t* blob = &signature->blobs[signature->nblobs++];
+        uint32_t index = sizeof(CS_SuperBlob) + i * sizeof(CS_BlobIndex);
+        cs_span_read32(signature->superblob, index, &blob->type);
+        cs_span_read32(signature->superblob, index + 4, &blob->offset);
         
-        uint32_t cmd = ctx->is_swap ? swap32(lc->cmd) : lc->cmd;
+        // A header outside the signature leaves the view empty
+        if (!cs_span_read32(signature->superblob, blob->offset, &blob->magic) ||
+            !cs_span_read32(signature->superblob, blob->offset + 4, &blob->length)) {
+            blob->magic = 0;
+            continue;
+        }
         
-        if (cmd == LC_CODE_SIGNATURE) {
-            struct linkedit_data_command* cs_cmd = (struct linkedit_data_command*)lc;
-            *offset = ctx->is_swap ? swap32(cs_cmd->dataoff) : cs_cmd->dataoff;
-            *size = ctx->is_swap ? swap32(cs_cmd->datasize) : cs_cmd->datasize;
-            
-            if (*offset + *size > ctx->size) {
-                return ERROR_NO_CODE_SIGNATURE;
-            }
-            
-            return SUCCESS;
+        uint32_t available = signature->superblob.size - blob->offset;
+        blob->truncated = blob->length > available;
+        cs_span_sub(signature->superblob, blob->offset, blob->truncated ? available : blob->length, &blob->blob);
+    }
+    
+    // Index the primary and alternate CodeDirectories with their cdhashes
+    for (uint32_t i = 0; i < CS_MAX_CODE_DIRECTORIES; i++) {
+        uint32_t slot = i ? CSSLOT_ALTERNATE_CODEDIRECTORIES + i - 1 : CSSLOT_CODEDIRECTORY;
+        const cs_blob_t* blob = cs_find_blob(signature, slot, CSMAGIC_CODEDIRECTORY);
+        if (!blob) continue;
+        
+        cs_code_directory_t* dir = &signature->dirs[signature->ndirs++];
+        dir->slot = slot;
+        dir->blob = blob->blob;
+        if (blob->blob.size >= sizeof(CS_CodeDirectory)) {
+            dir->hash_type = blob->blob.data[offsetof(CS_CodeDirectory, hashType)];
+            dir->has_cdhash = code_directory_hash(blob->blob, dir->hash_type, dir->cdhash);
         }
     }
     
-    return ERROR_NO_CODE_SIGNATURE;
+    return SUCCESS;
+}
+
+// Get the SuperBlob index owned by the context, building it on first use
+macho_error_t get_code_signature(const macho_ctx_t* ctx, const cs_signature_t** signature) {
+    if (!ctx || !ctx->cache || !ctx->data || !signature) return ERROR_READ_FAILED;
+    
+    macho_cache_t* cache = ctx->cache;
+    pthread_mutex_lock(&cache->lock);
+    if (!cache->signature_built) {
+        cache->signature_err = build_code_signature(ctx, &cache->signature);
+        cache->signature_built = 1;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    
+    *signature = &cache->signature;
+    return cache->signature_err;
+}
+
+// First complete blob in a slot, magic 0 matches any blob
+const cs_blob_t* cs_find_blob(const cs_signature_t* signature, uint32_t type, uint32_t magic) {
+    if (!signature) return NULL;
+    
+    for (uint32_t i = 0; i < signature->nblobs; i++) {
+        const cs_blob_t* blob = &signature->blobs[i];
+        if (blob->type != type || blob->truncated || blob->blob.size < 8) continue;
+        if (magic && blob->magic != magic) continue;
+        return blob;
+    }
+    return NULL;
+}
+
+void free_code_signature(cs_signature_t* signature) {
+    if (!signature) return;
+    
+    free(signature->blobs);
+    signature->blobs = NULL;
+    signature->nblobs = 0;
 }
 
 // Parse code signature blob
-macho_error_t parse_code_signature(const macho_ctx_t* ctx) {
+macho_error_t parse_code_signature(output_t* out, const macho_ctx_t* ctx) {
     if (!ctx || !ctx->data) return ERROR_READ_FAILED;
     
-    uint32_t cs_offset, cs_size;
-    macho_error_t err = find_code_signature(ctx, &cs_offset, &cs_size);
-    if (err != SUCCESS) {
-        printf("Code Signature: Not found\n");
+    output_begin_object(out, "code_signature", "Code Signature");
+    
+    const cs_signature_t* signature;
+    macho_error_t err = get_code_signature(ctx, &signature);
+    if (err != SUCCESS && !signature->error) {
+        output_str(out, "error", "Error", macho_strerror(err));
+        output_end_object(out);
         return err;
     }
     
-    printf("Code Signature:\n");
-    printf("  Offset: 0x%x\n", cs_offset);
-    printf("  Size: %u bytes\n", cs_size);
+    output_hex(out, "offset", "Offset", signature->offset);
+    output_uint(out, "size", "Size", signature->size);
     
-    // Parse SuperBlob structure
-    CS_SuperBlob* superblob = (CS_SuperBlob*)((char*)ctx->data + cs_offset);
-    
-    // Check magic
-    uint32_t magic = ctx->is_swap ? swap32(superblob->magic) : superblob->magic;
-    if (magic != CSMAGIC_EMBEDDED_SIGNATURE) {
-        printf("  Error: Invalid code signature magic (0x%x)\n", magic);
-        return ERROR_NO_CODE_SIGNATURE;
+    if (signature->error) {
+        output_str(out, "error", "Error", signature->error);
+        if (signature->size >= sizeof(CS_SuperBlob)) {
+            output_hex(out, "magic", "Magic", signature->magic);
+        }
+        output_end_object(out);
+        return err;
     }
     
-    uint32_t length = ctx->is_swap ? swap32(superblob->length) : superblob->length;
-    uint32_t count = ctx->is_swap ? swap32(superblob->count) : superblob->count;
-    
-    printf("  SuperBlob Length: %u\n", length);
-    printf("  Number of Blobs: %u\n", count);
+    output_uint(out, "length", "SuperBlob Length", signature->length);
+    output_uint(out, "count", "Number of Blobs", signature->count);
     
     // Parse each blob in the SuperBlob
-    for (uint32_t i = 0; i < count; i++) {
-        CS_BlobIndex* index = &superblob->index[i];
-        uint32_t blob_type = ctx->is_swap ? swap32(index->type) : index->type;
-        uint32_t blob_offset = ctx->is_swap ? swap32(index->offset) : index->offset;
-        
-        // Get blob header
-        struct __Blob {
-            uint32_t magic;
-            uint32_t length;
-        } *blob = (struct __Blob*)((char*)superblob + blob_offset);
-        
-        uint32_t blob_magic = ctx->is_swap ? swap32(blob->magic) : blob->magic;
-        uint32_t blob_length = ctx->is_swap ? swap32(blob->length) : blob->length;
-        
-        const char* type_name = "UNKNOWN";
-        switch (blob_type) {
-            case 0: type_name = "Code Directory"; break;
-            case 1: type_name = "Info Slots"; break;
-            case 2: type_name = "Requirements"; break;
-            case 3: type_name = "Resource Directory"; break;
-            case 4: type_name = "Application Specific"; break;
-            case 5: type_name = "Entitlements"; break;
-            default: type_name = "Unknown"; break;
-        }
-        
-        printf("  Blob %u:\n", i);
-        printf("    Type: %s (%d)\n", type_name, blob_type);
-        printf("    Offset: 0x%x\n", blob_offset);
-        printf("    Magic: 0x%x\n", blob_magic);
-        printf("    Length: %u\n", blob_length);
-        
-        // Parse Code Directory if present
-        if (blob_type == 0 && blob_magic == CSMAGIC_CODEDIRECTORY) {
-            CS_CodeDirectory* cd = (CS_CodeDirectory*)blob;
-            uint32_t version = ctx->is_swap ? swap32(cd->version) : cd->version;
-            uint32_t flags = ctx->is_swap ? swap32(cd->flags) : cd->flags;
-            uint32_t hashOffset = ctx->is_swap ? swap32(cd->hashOffset) : cd->hashOffset;
-            uint32_t identOffset = ctx->is_swap ? swap32(cd->identOffset) : cd->identOffset;
-            uint32_t nSpecialSlots = ctx->is_swap ? swap32(cd->nSpecialSlots) : cd->nSpecialSlots;
-            uint32_t nCodeSlots = ctx->is_swap ? swap32(cd->nCodeSlots) : cd->nCodeSlots;
-            uint32_t codeLimit = ctx->is_swap ? swap32(cd->codeLimit) : cd->codeLimit;
-            uint8_t hashSize = cd->hashSize;
-            uint8_t hashType = cd->hashType;
+    output_begin_stream(out, "blobs", NULL, signature->nblobs);
+    for (uint32_t i = 0; i < signature->nblobs; i++) {
+        const cs_blob_t* entry = &signature->blobs[i];
+        
+        char label[32];
+        snprintf(label, sizeof(label), "Blob %u", i);
+        output_begin_object(out, "blob", label);
+        
+        char type_str[64];
+        snprintf(type_str, sizeof(type_str), "%s (0x%x)", blob_type_name(entry->type), entry->type);
+        output_str(out, "slot_name", "Type", type_str);
+        output_uint(out, "slot", NULL, entry->type);
+        output_hex(out, "offset", "Offset", entry->offset);
+        
+        if (!entry->blob.data) {
+            output_str(out, "error", "Error", "Blob outside the signature");
+            output_end_object(out);
+            continue;
+        }
+        
+        output_hex(out, "magic", "Magic", entry->magic);
+        output_uint(out, "length", "Length", entry->length);
+        
+        // Parse the primary and alternate Code Directories
+        cs_span_t blob = entry->blob;
+        if (is_code_directory_slot(entry->type) && entry->magic == CSMAGIC_CODEDIRECTORY && blob.size >= sizeof(CS_CodeDirectory)) {
+            // Alternates are often not 4-byte aligned, read fields through their offsets
+            uint32_t version = cd_field32(blob, offsetof(CS_CodeDirectory, version));
+            uint32_t flags = cd_field32(blob, offsetof(CS_CodeDirectory, flags));
+            uint32_t hashOffset = cd_field32(blob, offsetof(CS_CodeDirectory, hashOffset));
+            uint32_t identOffset = cd_field32(blob, offsetof(CS_CodeDirectory, identOffset));
+            uint32_t nSpecialSlots = cd_field32(blob, offsetof(CS_CodeDirectory, nSpecialSlots));
+            uint32_t nCodeSlots = cd_field32(blob, offsetof(CS_CodeDirectory, nCodeSlots));
+            uint32_t codeLimit = cd_field32(blob, offsetof(CS_CodeDirectory, codeLimit));
+            uint8_t hashSize = blob.data[offsetof(CS_CodeDirectory, hashSize)];
+            uint8_t hashType = blob.data[offsetof(CS_CodeDirectory, hashType)];
             
-            const char* identifier = (const char*)cd + identOffset;
+            // Identifier is NUL terminated inside the blob
+            const char* identifier = "";
+            size_t ident_len = 0;
+            if (identOffset < blob.size) {
+                identifier = (const char*)blob.data + identOffset;
+                const char* end = memchr(identifier, '\0', blob.size - identOffset);
+                ident_len = end ? (size_t)(end - identifier) : blob.size - identOffset;
+            }
+            
+            output_begin_object(out, "code_directory", "Code Directory");
+            output_uint(out, "version", "Version", version);
+            output_hex(out, "flags", "Flags", flags);
+            output_hex(out, "hash_offset", "Hash Offset", hashOffset);
+            output_strn(out, "identifier", "Identifier", identifier, ident_len);
+            output_uint(out, "special_slots", "Special Slots", nSpecialSlots);
+            output_uint(out, "code_slots", "Code Slots", nCodeSlots);
+            output_hex(out, "code_limit", "Code Limit", codeLimit);
+            output_uint(out, "hash_size", "Hash Size", hashSize);
+            output_uint(out, "hash_type", "Hash Type", hashType);
+            output_str(out, "hash_type_name", NULL, cs_hash_type_name(hashType));
             
-            printf("    Code Directory:\n");
-            printf("      Version: %u\n", version);
-            printf("      Flags: 0x%x\n", flags);
-            printf("      Hash Offset: 0x%x\n", hashOffset);
-            printf("      Identifier: %s\n", identifier);
-            printf("      Special Slots: %u\n", nSpecialSlots);
-            printf("      Code Slots: %u\n", nCodeSlots);
-            printf("      Code Limit: 0x%x\n", codeLimit);
-            printf("      Hash Size: %u\n", hashSize);
-            printf("      Hash Type: %u\n", hashType);
+            uint8_t cdhash[CS_CDHASH_LEN];
+            if (!entry->truncated && code_directory_hash(blob, hashType, cdhash)) {
+                char cdhash_str[CS_CDHASH_LEN * 2 + 1];
+                format_cdhash(cdhash, cdhash_str);
+                output_str(out, "cdhash", "CDHash", cdhash_str);
+            }
+            output_end_object(out);
         }
         
-        // Parse entitlements blob if present
-        if (blob_type == 5 && blob_magic == CSMAGIC_EMBEDDED_ENTITLEMENTS) {
-            printf("    Entitlements Blob Found\n");
-            // Entitlements parsing is handled in entitlements.c
+        // Entitlements parsing is handled in entitlements.c
+        if (entry->type == CSSLOT_ENTITLEMENTS && entry->magic == CSMAGIC_EMBEDDED_ENTITLEMENTS) {
+            output_bool(out, "entitlements", "Entitlements Blob Found", 1);
         }
+        if (entry->type == CSSLOT_DER_ENTITLEMENTS && entry->magic == CSMAGIC_EMBEDDED_DER_ENTITLEMENTS) {
+            output_bool(out, "der_entitlements", "DER Entitlements Blob Found", 1);
+        }
+        output_end_object(out);
+    }
+    output_end_array(out);
+    
+    // The strongest hash type is the one the kernel validates and identifies the binary by
+    int best = preferred_code_directory(signature->dirs, signature->ndirs);
+    if (best >= 0) {
+        char cdhash_str[CS_CDHASH_LEN * 2 + 1];
+        format_cdhash(signature->dirs[best].cdhash, cdhash_str);
+        output_hex(out, "preferred_code_directory", "Preferred Code Directory", signature->dirs[best].slot);
+        output_str(out, "cdhash", "CDHash", cdhash_str);
     }
+    output_end_object(out);
     
     return SUCCESS;
 }
 
+// Code slots re-hashed by one task, mismatches are merged in slot order
+typedef struct {
+    const uint8_t* image;
+    const uint8_t* hashes;          // Expected hash of the first slot in the range
+    digest_type_t digest;
+    uint32_t hash_size;
+    uint64_t page_size;
+    uint64_t code_limit;
+    uint32_t first_slot;
+    uint32_t nslots;
+    uint32_t bad;
+    uint32_t bad_slots[CS_VERIFY_MAX_REPORTED];
+} page_hash_job_t;
+
+// Re-hash a run of code pages, the last page stops at the code limit
+static void hash_pages_task(void* arg) {
+    page_hash_job_t* job = (page_hash_job_t*)arg;
+    uint8_t digest[DIGEST_MAX_SIZE];
+    
+    for (uint32_t i = 0; i < job->nslots; i++) {
+        uint32_t slot = job->first_slot + i;
+        uint64_t start = (uint64_t)slot * job->page_size;
+        uint64_t length = job->code_limit - start;
+        if (length > job->page_size) length = job->page_size;
+        
+        digest_buffer(job->digest, job->image + start, (size_t)length, digest);
+        if (memcmp(digest, job->hashes + (size_t)i * job->hash_size, job->hash_size) != 0) {
+            if (job->bad < CS_VERIFY_MAX_REPORTED) {
+                job->bad_slots[job->bad] = slot;
+            }
+            job->bad++;
+        }
+    }
+}
+
+// Compare one CodeDirectory against the image and the blobs it seals
+static void verify_code_directory(const macho_ctx_t* ctx, const cs_signature_t* signature, cs_span_t cd, thread_pool_t* pool, cs_verify_t* result) {
+    uint32_t version = cd_field32(cd, offsetof(CS_CodeDirectory, version));
+    uint32_t hash_offset = cd_field32(cd, offsetof(CS_CodeDirectory, hashOffset));
+    uint32_t nspecial = cd_field32(cd, offsetof(CS_CodeDirectory, nSpecialSlots));
+    uint32_t ncode = cd_field32(cd, offsetof(CS_CodeDirectory, nCodeSlots));
+    uint64_t code_limit = cd_field32(cd, offsetof(CS_CodeDirectory, codeLimit));
+    uint8_t hash_size_field = cd.data[offsetof(CS_CodeDirectory, hashSize)];
+    uint8_t page_shift = cd.data[offsetof(CS_CodeDirectory, pageSize)];
+    
+    result->hash_type = cd.data[offsetof(CS_CodeDirectory, hashType)];
+    
+    // codeLimit64 follows scatterOffset, teamOffset and spare3
+    uint32_t limit64_hi, limit64_lo;
+    if (version >= CS_SUPPORTSCODELIMIT64 &&
+        cs_span_read32(cd, sizeof(CS_CodeDirectory) + 12, &limit64_hi) &&
+        cs_span_read32(cd, sizeof(CS_CodeDirectory) + 16, &limit64_lo)) {
+        uint64_t value = ((uint64_t)limit64_hi << 32) | limit64_lo;
+        if (value) code_limit = value;
+    }
+    result->code_limit = code_limit;
+    
+    digest_type_t digest;
+    uint32_t hash_size;
+    if (!cs_digest_type(result->hash_type, &digest, &hash_size)) {
+        result->error = "Unsupported hash type";
+        return;
+    }
+    if (hash_size_field != hash_size) {
+        result->error = "Hash size does not match the hash type";
+        return;
+    }
+    if ((uint64_t)hash_offset + (uint64_t)ncode * hash_size > cd.size ||
+        (uint64_t)nspecial * hash_size > hash_offset) {
+        result->error = "Hash slots outside the CodeDirectory";
+        return;
+    }
+    if (code_limit > ctx->size) {
+        result->error = "Code limit past the end of the image";
+        return;
+    }
+    if (page_shift >= 32) {
+        result->error = "Invalid page size";
+        return;
+    }
+    
+    // A zero page size means one hash covers the whole code limit
+    uint64_t page_size = page_shift ? (uint64_t)1 << page_shift : code_limit;
+    result->page_size = page_shift ? (uint32_t)page_size : 0;
+    uint64_t needed = page_size ? (code_limit + page_size - 1) / page_size : 0;
+    if (needed != ncode) {
+        result->error = "Code slots do not cover the code limit";
+        return;
+    }
+    result->code_slots = ncode;
+    
+    const uint8_t* hashes = cd.data + hash_offset;
+    const uint8_t* image = (const uint8_t*)ctx->data;
+    
+    // Split the pages into chunks of about CS_VERIFY_CHUNK_SIZE bytes
+    uint32_t per_job = page_size && page_size < CS_VERIFY_CHUNK_SIZE ? (uint32_t)(CS_VERIFY_CHUNK_SIZE / page_size) : 1;
+    uint32_t njobs = ncode ? (ncode + per_job - 1) / per_job : 0;
+    page_hash_job_t* jobs = njobs ? calloc(njobs, sizeof(page_hash_job_t)) : NULL;
+    if (njobs && !jobs) {
+        result->error = "Out of memory";
+        return;
+    }
+    
+    if (ctx->file && ctx->file->is_mapped) {
+        advise_file_range(ctx->data, ctx->size, 0, code_limit, ADVISE_WILLNEED);
+    }
+    
+    for (uint32_t j = 0; j < njobs; j++) {
+        page_hash_job_t* job = &jobs[j];
+        job->image = image;
+        job->digest = digest;
+        job->hash_size = hash_size;
+        job->page_size = page_size;
+        job->code_limit = code_limit;
+        job->first_slot = j * per_job;
+        job->nslots = ncode - job->first_slot < per_job ? ncode - job->first_slot : per_job;
+        job->hashes = hashes + (size_t)job->first_slot * hash_size;
+        if (!pool || njobs == 1 || thread_pool_submit(pool, hash_pages_task, job) != SUCCESS) {
+            hash_pages_task(job);
+        }
+    }
+    if (pool && njobs > 1) {
+        thread_pool_wait(pool);
+    }
+    
+    // Merge in slot order so the reported pages do not depend on scheduling
+    uint32_t reported = 0;
+    for (uint32_t j = 0; j < njobs; j++) {
+        uint32_t listed = jobs[j].bad < CS_VERIFY_MAX_REPORTED ? jobs[j].bad : CS_VERIFY_MAX_REPORTED;
+        for (uint32_t k = 0; k < listed && reported < CS_VERIFY_MAX_REPORTED; k++) {
+            result->bad_slots[reported++] = jobs[j].bad_slots[k];
+        }
+        result->bad_code_slots += jobs[j].bad;
+    }
+    free(jobs);
+    
+    // Special slot k sits k hashes before hashOffset and seals the blob of type k.
+    // An all-zero hash seals nothing, any other hash needs its blob present and whole.
+    uint8_t blob_digest[DIGEST_MAX_SIZE];
+    static const uint8_t zero_hash[DIGEST_MAX_SIZE];
+    for (uint32_t k = 1; k <= nspecial; k++) {
+        if (k == CSSLOT_INFOSLOT || k == CSSLOT_RESOURCEDIR) continue;
+        
+        const uint8_t* expected = hashes - (size_t)k * hash_size;
+        const cs_blob_t* blob = cs_find_blob(signature, k, 0);
+        if (!blob && memcmp(expected, zero_hash, hash_size) == 0) continue;
+        
+        const char* reason = NULL;
+        if (!blob) {
+            // cs_find_blob() skips blobs cut short of their header length
+            reason = "blob missing";
+            for (uint32_t i = 0; i < signature->nblobs; i++) {
+                if (signature->blobs[i].type == k) reason = "blob truncated";
+            }
+        } else {
+            digest_buffer(digest, blob->blob.data, blob->blob.size, blob_digest);
+            if (memcmp(blob_digest, expected, hash_size) != 0) reason = "hash mismatch";
+        }
+        
+        result->special_slots++;
+        if (reason) {
+            if (result->bad_special_slots < CS_VERIFY_MAX_REPORTED) {
+                result->bad_special[result->bad_special_slots] = k;
+                result->bad_special_reason[result->bad_special_slots] = reason;
+            }
+            result->bad_special_slots++;
+        }
+    }
+}
+
+// Primary and alternate CodeDirectories from the cached SuperBlob index
+macho_error_t get_code_directories(const macho_ctx_t* ctx, const cs_code_directory_t** dirs, uint32_t* count) {
+    if (!dirs || !count) return ERROR_READ_FAILED;
+    
+    *dirs = NULL;
+    *count = 0;
+    
+    const cs_signature_t* signature;
+    macho_error_t err = get_code_signature(ctx, &signature);
+    if (err != SUCCESS) return err;
+    if (signature->ndirs == 0) return ERROR_NO_CODE_SIGNATURE;
+    
+    *dirs = signature->dirs;
+    *count = signature->ndirs;
+    return SUCCESS;
+}
+
+// Index of the CodeDirectory with the strongest hash type, -1 when none is usable
+int preferred_code_directory(const cs_code_directory_t* dirs, uint32_t count) {
+    int best = -1;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!dirs[i].has_cdhash) continue;
+        if (best < 0 || hash_type_rank(dirs[i].hash_type) > hash_type_rank(dirs[best].hash_type)) {
+            best = (int)i;
+        }
+    }
+    return best;
+}
+
+// cdhash of the preferred CodeDirectory
+macho_error_t compute_cdhash(const macho_ctx_t* ctx, uint8_t* cdhash, uint8_t* hash_type) {
+    if (!cdhash) return ERROR_READ_FAILED;
+    
+    const cs_code_directory_t* dirs;
+    uint32_t count;
+    macho_error_t err = get_code_directories(ctx, &dirs, &count);
+    if (err != SUCCESS) return err;
+    
+    int best = preferred_code_directory(dirs, count);
+    if (best < 0) return ERROR_NO_CODE_SIGNATURE;
+    
+    memcpy(cdhash, dirs[best].cdhash, CS_CDHASH_LEN);
+    if (hash_type) *hash_type = dirs[best].hash_type;
+    return SUCCESS;
+}
+
+const char* cs_hash_type_name(uint8_t hash_type) {
+    switch (hash_type) {
+        case CS_HASHTYPE_SHA1: return "SHA-1";
+        case CS_HASHTYPE_SHA256: return "SHA-256";
+        case CS_HASHTYPE_SHA256_TRUNCATED: return "SHA-256 (truncated)";
+        case CS_HASHTYPE_SHA384: return "SHA-384";
+        default: return "Unknown";
+    }
+}
+
+// Lowercase hex as printed by codesign, str holds CS_CDHASH_LEN * 2 + 1 bytes
+void format_cdhash(const uint8_t* cdhash, char* str) {
+    static const char digits[] = "0123456789abcdef";
+    for (uint32_t i = 0; i < CS_CDHASH_LEN; i++) {
+        str[i * 2] = digits[cdhash[i] >> 4];
+        str[i * 2 + 1] = digits[cdhash[i] & 0xf];
+    }
+    str[CS_CDHASH_LEN * 2] = '\0';
+}
+
+// Verify every CodeDirectory in the signature, results holds one entry per directory
+macho_error_t verify_code_signature(const macho_ctx_t* ctx, uint32_t nthreads, cs_verify_t** results, uint32_t* count) {
+    if (!ctx || !ctx->data || !results || !count) return ERROR_READ_FAILED;
+    
+    *results = NULL;
+    *count = 0;
+    
+    const cs_signature_t* signature;
+    macho_error_t err = get_code_signature(ctx, &signature);
+    if (err != SUCCESS) return err;
+    
+    const cs_code_directory_t* dirs = signature->dirs;
+    uint32_t ndirs = signature->ndirs;
+    if (ndirs == 0) return ERROR_NO_CODE_SIGNATURE;
+    
+    cs_verify_t* list = calloc(ndirs, sizeof(cs_verify_t));
+    if (!list) return ERROR_READ_FAILED;
+    
+    thread_pool_t* pool = nthreads == 1 ? NULL : thread_pool_create(nthreads, 0);
+    
+    for (uint32_t i = 0; i < ndirs; i++) {
+        cs_verify_t* result = &list[i];
+        result->slot = dirs[i].slot;
+        if (dirs[i].blob.size < sizeof(CS_CodeDirectory)) {
+            result->error = "CodeDirectory too small";
+            continue;
+        }
+        verify_code_directory(ctx, signature, dirs[i].blob, pool, result);
+    }
+    
+    if (pool) {
+        thread_pool_destroy(pool);
+    }
+    
+    *results = list;
+    *count = ndirs;
+    return SUCCESS;
+}
+
+// A signature is valid when every CodeDirectory matched
+int code_signature_valid(const cs_verify_t* results, uint32_t count) {
+    if (!results || count == 0) return 0;
+    
+    for (uint32_t i = 0; i < count; i++) {
+        if (results[i].error || results[i].bad_code_slots || results[i].bad_special_slots) return 0;
+    }
+    return 1;
+}
+
+// Print the result of re-hashing the signed pages, returns 0 when a signature fails to verify.
+// An unsigned slice has nothing to verify, as in batch mode.
+int print_signature_verification(output_t* out, const macho_ctx_t* ctx, uint32_t nthreads) {
+    output_begin_object(out, "signature_verification", "Code Signature Verification");
+    
+    cs_verify_t* results;
+    uint32_t count;
+    macho_error_t err = verify_code_signature(ctx, nthreads, &results, &count);
+    if (err != SUCCESS) {
+        output_str(out, "error", "Error", macho_strerror(err));
+        output_end_object(out);
+        return err == ERROR_NO_CODE_SIGNATURE;
+    }
+    
+    output_begin_array(out, "code_directories", NULL, count);
+    for (uint32_t i = 0; i < count; i++) {
+        const cs_verify_t* result = &results[i];
+        
+        char label[48];
+        snprintf(label, sizeof(label), "Code Directory (slot 0x%x)", result->slot);
+        output_begin_object(out, "code_directory", label);
+        output_hex(out, "slot", NULL, result->slot);
+        
+        output_str(out, "hash_type", "Hash Type", cs_hash_type_name(result->hash_type));
+        
+        if (result->error) {
+            output_str(out, "error", "Error", result->error);
+            output_bool(out, "valid", "Valid", 0);
+            output_end_object(out);
+            continue;
+        }
+        
+        output_hex(out, "code_limit", "Code Limit", result->code_limit);
+        output_uint(out, "page_size", "Page Size", result->page_size);
+        output_uint(out, "code_slots", "Code Slots", result->code_slots);
+        output_uint(out, "bad_code_slots", "Mismatched Code Slots", result->bad_code_slots);
+        
+        uint32_t listed = result->bad_code_slots < CS_VERIFY_MAX_REPORTED ? result->bad_code_slots : CS_VERIFY_MAX_REPORTED;
+        if (listed) {
+            output_begin_array(out, "bad_pages", "Mismatched Pages", listed);
+            for (uint32_t j = 0; j < listed; j++) {
+                uint64_t page_size = result->page_size ? result->page_size : result->code_limit;
+                output_begin_inline(out, "page", "Page");
+                output_uint(out, "slot", "slot", result->bad_slots[j]);
+                output_hex(out, "offset", "offset", (uint64_t)result->bad_slots[j] * page_size);
+                output_end_object(out);
+            }
+            output_end_array(out);
+        }
+        
+        output_uint(out, "special_slots", "Special Slots Checked", result->special_slots);
+        output_uint(out, "bad_special_slots", "Mismatched Special Slots", result->bad_special_slots);
+        
+        listed = result->bad_special_slots < CS_VERIFY_MAX_REPORTED ? result->bad_special_slots : CS_VERIFY_MAX_REPORTED;
+        if (listed) {
+            output_begin_array(out, "bad_special", "Failed Special Slots", listed);
+            for (uint32_t j = 0; j < listed; j++) {
+                output_begin_inline(out, "special", "Special");
+                output_uint(out, "slot", "slot", result->bad_special[j]);
+                output_str(out, "type", "type", blob_type_name(result->bad_special[j]));
+                output_str(out, "reason", "reason", result->bad_special_reason[j]);
+                output_end_object(out);
+            }
+            output_end_array(out);
+        }
+        output_bool(out, "valid", "Valid", !result->bad_code_slots && !result->bad_special_slots);
+        output_end_object(out);
+    }
+    output_end_array(out);
+    
+    int valid = code_signature_valid(results, count);
+    output_bool(out, "valid", "Signature Valid", valid);
+    output_end_object(out);
+    free(results);
+    return valid;
+}
+
 // Print code signature information
 void print_code_signature_info(const CS_SuperBlob* superblob) {
     if (!superblob) return;
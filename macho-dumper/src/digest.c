@@ -0,0 +1,291 @@
+/*
+* digest.c
+* Coded by iosmen (c) 2025
+*/
+#include "../include/digest.h"
+#include <string.h>
+
+#ifdef __APPLE__
+#include <CommonCrypto/CommonDigest.h>
+
+// CommonCrypto uses the SHA instructions of the CPU when there are any
+#define CC_CHUNK_SIZE 0x40000000u
+
+#define CC_DIGEST(name, ctx_type, data, len, out) do {                     \
+    ctx_type cc_ctx;                                                        \
+    const uint8_t* cc_data = (const uint8_t*)(data);                        \
+    size_t cc_len = (len);                                                  \
+    CC_##name##_Init(&cc_ctx);                                              \
+    while (cc_len > 0) {                                                    \
+        CC_LONG chunk = cc_len > CC_CHUNK_SIZE ? CC_CHUNK_SIZE : (CC_LONG)cc_len; \
+        CC_##name##_Update(&cc_ctx, cc_data, chunk);                        \
+        cc_data += chunk;                                                   \
+        cc_len -= chunk;                                                    \
+    }                                                                       \
+    CC_##name##_Final((out), &cc_ctx);                                      \
+} while (0)
+
+#else
+
+// Portable implementations (FIPS 180-4) for hosts without CommonCrypto
+
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define ROTR64(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+typedef void (*block_fn)(void* state, const uint8_t* block);
+
+static uint32_t load_be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint64_t load_be64(const uint8_t* p) {
+    return ((uint64_t)load_be32(p) << 32) | load_be32(p + 4);
+}
+
+static void store_be32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static void store_be64(uint8_t* p, uint64_t v) {
+    store_be32(p, (uint32_t)(v >> 32));
+    store_be32(p + 4, (uint32_t)v);
+}
+
+// Merkle-Damgard framing shared by the three hashes: every full block, then the tail padded
+// with 0x80, zeros and the bit length in the last 8 bytes (SHA-384 has a 16 byte length field,
+// its upper half is zero for any buffer that fits in memory)
+static void hash_message(void* state, block_fn block, size_t block_size, const uint8_t* data, size_t len) {
+    uint8_t tail[256];
+    size_t full = len - len % block_size;
+    
+    for (size_t i = 0; i < full; i += block_size) {
+        block(state, data + i);
+    }
+    
+    size_t rest = len - full;
+    size_t length_size = block_size == 128 ? 16 : 8;
+    size_t tail_len = rest + 1 + length_size <= block_size ? block_size : block_size * 2;
+    memset(tail, 0, tail_len);
+    memcpy(tail, data + full, rest);
+    tail[rest] = 0x80;
+    store_be64(tail + tail_len - 8, (uint64_t)len << 3);
+    
+    for (size_t i = 0; i < tail_len; i += block_size) {
+        block(state, tail + i);
+    }
+}
+
+static void sha1_block(void* state, const uint8_t* block) {
+    uint32_t* h = (uint32_t*)state;
+    uint32_t w[80];
+    
+    for (int i = 0; i < 16; i++) {
+        w[i] = load_be32(block + i * 4);
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = ROTL32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+    
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5a827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ed9eba1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8f1bbcdc;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xca62c1d6;
+        }
+        uint32_t t = ROTL32(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = ROTL32(b, 30);
+        b = a;
+        a = t;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+}
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static void sha256_block(void* state, const uint8_t* block) {
+    uint32_t* h = (uint32_t*)state;
+    uint32_t w[64];
+    
+    for (int i = 0; i < 16; i++) {
+        w[i] = load_be32(block + i * 4);
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = ROTR32(w[i - 15], 7) ^ ROTR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROTR32(w[i - 2], 17) ^ ROTR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t s1 = ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25);
+        uint32_t ch = (e & f) ^ (~e & g);
+        uint32_t t1 = hh + s1 + ch + sha256_k[i] + w[i];
+        uint32_t s0 = ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22);
+        uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t t2 = s0 + maj;
+        hh = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+    h[5] += f;
+    h[6] += g;
+    h[7] += hh;
+}
+
+static const uint64_t sha512_k[80] = {
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+    0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+    0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+    0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+    0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+    0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+    0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+    0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+    0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+    0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+    0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+    0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+    0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+    0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+static void sha512_block(void* state, const uint8_t* block) {
+    uint64_t* h = (uint64_t*)state;
+    uint64_t w[80];
+    
+    for (int i = 0; i < 16; i++) {
+        w[i] = load_be64(block + i * 8);
+    }
+    for (int i = 16; i < 80; i++) {
+        uint64_t s0 = ROTR64(w[i - 15], 1) ^ ROTR64(w[i - 15], 8) ^ (w[i - 15] >> 7);
+        uint64_t s1 = ROTR64(w[i - 2], 19) ^ ROTR64(w[i - 2], 61) ^ (w[i - 2] >> 6);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    
+    uint64_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+    for (int i = 0; i < 80; i++) {
+        uint64_t s1 = ROTR64(e, 14) ^ ROTR64(e, 18) ^ ROTR64(e, 41);
+        uint64_t ch = (e & f) ^ (~e & g);
+        uint64_t t1 = hh + s1 + ch + sha512_k[i] + w[i];
+        uint64_t s0 = ROTR64(a, 28) ^ ROTR64(a, 34) ^ ROTR64(a, 39);
+        uint64_t maj = (a & b) ^ (a & c) ^ (b & c);
+        uint64_t t2 = s0 + maj;
+        hh = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+    h[5] += f;
+    h[6] += g;
+    h[7] += hh;
+}
+
+#endif
+
+size_t digest_size(digest_type_t type) {
+    switch (type) {
+        case DIGEST_SHA1: return 20;
+        case DIGEST_SHA256: return 32;
+        case DIGEST_SHA384: return 48;
+    }
+    return 0;
+}
+
+const char* digest_name(digest_type_t type) {
+    switch (type) {
+        case DIGEST_SHA1: return "SHA-1";
+        case DIGEST_SHA256: return "SHA-256";
+        case DIGEST_SHA384: return "SHA-384";
+    }
+    return "Unknown";
+}
+
+// Hash a whole buffer in one call, out receives digest_size(type) bytes
+void digest_buffer(digest_type_t type, const void* data, size_t len, uint8_t* out) {
+#ifdef __APPLE__
+    switch (type) {
+        case DIGEST_SHA1: CC_DIGEST(SHA1, CC_SHA1_CTX, data, len, out); break;
+        case DIGEST_SHA256: CC_DIGEST(SHA256, CC_SHA256_CTX, data, len, out); break;
+        case DIGEST_SHA384: CC_DIGEST(SHA384, CC_SHA512_CTX, data, len, out); break;
+    }
+#else
+    switch (type) {
+        case DIGEST_SHA1: {
+            uint32_t h[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+            hash_message(h, sha1_block, 64, (const uint8_t*)data, len);
+            for (int i = 0; i < 5; i++) store_be32(out + i * 4, h[i]);
+            break;
+        }
+        case DIGEST_SHA256: {
+            uint32_t h[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                              0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+            hash_message(h, sha256_block, 64, (const uint8_t*)data, len);
+            for (int i = 0; i < 8; i++) store_be32(out + i * 4, h[i]);
+            break;
+        }
+        case DIGEST_SHA384: {
+            uint64_t h[8] = { 0xcbbb9d5dc1059ed8ULL, 0x629a292a367cd507ULL, 0x9159015a3070dd17ULL,
+                              0x152fecd8f70e5939ULL, 0x67332667ffc00b31ULL, 0x8eb44a8768581511ULL,
+                              0xdb0c2e0d64f98fa7ULL, 0x47b5481dbefa4fa4ULL };
+            hash_message(h, sha512_block, 128, (const uint8_t*)data, len);
+            for (int i = 0; i < 6; i++) store_be64(out + i * 8, h[i]);
+            break;
+        }
+    }
+#endif
+
+}
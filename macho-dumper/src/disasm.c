@@ -7,8 +7,19 @@
 #include <string.h>
 #include <stdlib.h>
 
+// Apply DISASM_* flags to a fresh handle. Detail mode makes Capstone fill operand
+// arrays for every instruction, which dominates decoding cost, so it is opt-in.
+static void apply_engine_options(csh handle, uint32_t flags) {
+    if (flags & DISASM_DETAIL) {
+        cs_option(handle, CS_OPT_DETAIL, CS_OPT_ON);
+    }
+    if (flags & DISASM_SKIPDATA) {
+        cs_option(handle, CS_OPT_SKIPDATA, CS_OPT_ON);
+    }
+}
+
 // Initialize Capstone disassembler
-macho_error_t init_disassembler(disasm_ctx_t* ctx, cs_arch arch, cs_mode mode) {
+macho_error_t init_disassembler(disasm_ctx_t* ctx, cs_arch arch, cs_mode mode, uint32_t flags) {
     if (!ctx) return ERROR_DISASM_FAILED;
     
     cs_err err = cs_open(arch, mode, &ctx->handle);
@@ -17,8 +28,7 @@ macho_error_t init_disassembler(disasm_ctx_t* ctx, cs_arch arch, cs_mode mode) {
         return ERROR_DISASM_FAILED;
     }
     
-    // Enable detailed mode
-    cs_option(ctx->handle, CS_OPT_DETAIL, CS_OPT_ON);
+    apply_engine_options(ctx->handle, flags);
     
     ctx->base_address = 0;
     ctx->code_size = 0;
@@ -45,140 +55,338 @@ void free_disassembler(disasm_ctx_t* ctx) {
     ctx->code_size = 0;
 }
 
-// Find __text section in Mach-O file
-macho_error_t find_text_section(const macho_ctx_t* ctx, uint8_t** code, 
-                               size_t* size, uint64_t* address) {
-    if (!ctx || !code || !size || !address) return ERROR_DISASM_FAILED;
+// Name of the symbol starting at address. next is a cursor into the sorted index that
+// only moves forward, so a linear sweep costs one comparison per instruction.
+static const char* symbol_at(const symbol_index_t* symbols, uint32_t* next, uint64_t address) {
+    if (!symbols) return NULL;
     
-    segment_info_t* segments = NULL;
-    uint32_t nsegments = 0;
-    macho_error_t err = parse_segment_commands(ctx, &segments, &nsegments);
-    if (err != SUCCESS) {
-        return err;
-    }
-    
-    // Search for __TEXT segment and __text section
-    for (uint32_t i = 0; i < nsegments; i++) {
-        if (strcmp(segments[i].segname, "__TEXT") == 0) {
-            for (uint32_t j = 0; j < segments[i].nsects; j++) {
-                if (strcmp(segments[i].sections[j].sectname, "__text") == 0) {
-                    section_info_t* text_section = &segments[i].sections[j];
-                    
-                    // Validate section data
-                    if (text_section->offset + text_section->size > ctx->size) {
-                        free_segments(segments, nsegments);
-                        return ERROR_INVALID_SECTION;
-                    }
-                    
-                    // Allocate memory for code copy
-                    *code = malloc(text_section->size);
-                    if (!*code) {
-                        free_segments(segments, nsegments);
-                        return ERROR_READ_FAILED;
-                    }
-                    
-                    // Copy code data
-                    memcpy(*code, (char*)ctx->data + text_section->offset, text_section->size);
-                    *size = text_section->size;
-                    *address = text_section->addr;
-                    
-                    free_segments(segments, nsegments);
-                    return SUCCESS;
-                }
-            }
-        }
+    while (*next < symbols->count && symbols->addresses[*next] < address) {
+        (*next)++;
     }
     
-    free_segments(segments, nsegments);
-    return ERROR_INVALID_SECTION;
+    // Aliases share an address, label with the first one that has a name
+    const char* name = NULL;
+    while (*next < symbols->count && symbols->addresses[*next] == address) {
+        const char* alias = symbol_name(symbols, *next);
+        if (!name && alias[0]) name = alias;
+        (*next)++;
+    }
+    return name;
 }
 
-// Disassemble a specific section
-macho_error_t disassemble_section(disasm_ctx_t* ctx, const char* section_name, 
-                                 const uint8_t* code, size_t size, uint64_t address) {
-    if (!ctx || !ctx->handle || !code || size == 0) return ERROR_DISASM_FAILED;
-    
-    printf("Disassembly of %s section (address: 0x%llx, size: %zu bytes):\n", 
-           section_name, address, size);
-    printf("--------------------------------------------------------------------------------\n");
+// One slice of a section decoded on a pool worker with its own Capstone handle
+typedef struct {
+    cs_arch arch;
+    cs_mode mode;
+    uint32_t flags;
+    uint32_t insn_width;
+    const uint8_t* code;
+    size_t size;
+    uint64_t address;
+    const symbol_index_t* symbols;
+    size_t count;
+    output_t out;               // Fragment continuing the section's instruction list
+    macho_error_t err;
+} disasm_chunk_t;
+
+// Instruction width when every instruction has the same size, 0 otherwise
+static uint32_t fixed_insn_width(cs_arch arch, cs_mode mode) {
+    if (arch == CS_ARCH_AARCH64) return 4;
+    if (arch == CS_ARCH_ARM && !(mode & CS_MODE_THUMB)) return 4;
+    return 0;
+}
+
+// Decode chunk->code into out with a handle of its own, instructions are counted in the chunk
+static void disasm_decode(disasm_chunk_t* chunk, output_t* out) {
+    csh handle;
+    if (cs_open(chunk->arch, chunk->mode, &handle) != CS_ERR_OK) {
+        chunk->err = ERROR_DISASM_FAILED;
+        return;
+    }
+    apply_engine_options(handle, chunk->flags);
     
-    // Disassemble the code
-    cs_insn* insn = cs_malloc(ctx->handle);
+    cs_insn* insn = cs_malloc(handle);
     if (!insn) {
-        return ERROR_DISASM_FAILED;
+        cs_close(&handle);
+        chunk->err = ERROR_DISASM_FAILED;
+        return;
     }
     
-    size_t code_size = size;
-    const uint8_t* code_ptr = code;
-    uint64_t current_addr = address;
-    size_t count = 0;
-    const size_t max_instructions = 100; // Limit output for large sections
+    const uint8_t* code_ptr = chunk->code;
+    size_t code_size = chunk->size;
+    uint64_t current_addr = chunk->address;
+    uint32_t next_symbol = symbol_lower_bound(chunk->symbols, chunk->address);
     
-    while (code_size > 0 && count < max_instructions) {
-        // Disassemble one instruction at a time
-        if (!cs_disasm_iter(ctx->handle, &code_ptr, &code_size, &current_addr, insn)) {
-            break;
+    while (code_size > 0) {
+        if (cs_disasm_iter(handle, &code_ptr, &code_size, &current_addr, insn)) {
+            output_insn(out, insn->address, insn->bytes, insn->size, insn->mnemonic, insn->op_str,
+                        symbol_at(chunk->symbols, &next_symbol, insn->address));
+            chunk->count++;
+            continue;
         }
         
-        // Print instruction
-        printf("  0x%llx: ", insn->address);
+        // Fixed-width code resumes at the next word (data in code), anything else stops here
+        uint32_t width = chunk->insn_width;
+        if (width == 0 || code_size < width) break;
         
-        // Print bytes (up to 8 bytes)
-        for (size_t j = 0; j < 8; j++) {
-            if (j < insn->size) {
-                printf("%02x ", insn->bytes[j]);
-            } else {
-                printf("   ");
+        char word[16];
+        snprintf(word, sizeof(word), "0x%02x%02x%02x%02x", code_ptr[3], code_ptr[2], code_ptr[1], code_ptr[0]);
+        output_insn(out, current_addr, code_ptr, width, ".long", word,
+                    symbol_at(chunk->symbols, &next_symbol, current_addr));
+        code_ptr += width;
+        code_size -= width;
+        current_addr += width;
+    }
+    
+    cs_free(insn, 1);
+    cs_close(&handle);
+}
+
+static void disasm_chunk_task(void* arg) {
+    disasm_chunk_t* chunk = (disasm_chunk_t*)arg;
+    disasm_decode(chunk, &chunk->out);
+}
+
+// Disassemble a whole section. Fixed-width code is cut into DISASM_CHUNK_SIZE pieces decoded
+// on the pool; a window of chunks is kept in flight and flushed in address order, so output
+// matches a serial run and memory stays bounded. Variable-width code cannot be split and is
+// decoded serially straight into out, nothing is buffered.
+macho_error_t disassemble_section_parallel(output_t* out, thread_pool_t* pool, cs_arch arch, cs_mode mode,
+                                          uint32_t flags, const char* section_name, const uint8_t* code,
+                                          size_t size, uint64_t address, const symbol_index_t* symbols) {
+    if (!code || size == 0) return ERROR_DISASM_FAILED;
+    
+    uint32_t width = fixed_insn_width(arch, mode);
+    size_t nchunks = width ? (size + DISASM_CHUNK_SIZE - 1) / DISASM_CHUNK_SIZE : 1;
+    size_t window = pool ? (size_t)thread_pool_size(pool) * 2 : 1;
+    if (window > nchunks) window = nchunks;
+    
+    char label[64];
+    snprintf(label, sizeof(label), "Disassembly of %s section", section_name);
+    output_begin_object(out, "disasm_section", label);
+    output_str(out, "section", NULL, section_name);
+    output_hex(out, "address", "Address", address);
+    output_uint(out, "size", "Size", size);
+    output_begin_stream(out, "instructions", NULL, 0);
+    
+    macho_error_t err = SUCCESS;
+    size_t offset = 0;
+    size_t count = 0;
+    
+    // A single piece has nothing to merge, it is decoded straight into out
+    disasm_chunk_t* chunks = NULL;
+    if (nchunks == 1) {
+        disasm_chunk_t chunk;
+        memset(&chunk, 0, sizeof(chunk));
+        chunk.arch = arch;
+        chunk.mode = mode;
+        chunk.flags = flags;
+        chunk.insn_width = width;
+        chunk.code = code;
+        chunk.size = size;
+        chunk.address = address;
+        chunk.symbols = symbols;
+        disasm_decode(&chunk, out);
+        err = chunk.err;
+        count = chunk.count;
+        offset = size;
+    } else if (!(chunks = calloc(window, sizeof(disasm_chunk_t)))) {
+        err = ERROR_DISASM_FAILED;
+    }
+    
+    while (offset < size && err == SUCCESS) {
+        size_t n = 0;
+        for (; n < window && offset < size; n++) {
+            size_t len = size - offset;
+            if (width && len > DISASM_CHUNK_SIZE) len = DISASM_CHUNK_SIZE;
+            
+            disasm_chunk_t* chunk = &chunks[n];
+            memset(chunk, 0, sizeof(disasm_chunk_t));
+            chunk->arch = arch;
+            chunk->mode = mode;
+            chunk->flags = flags;
+            chunk->insn_width = width;
+            chunk->code = code + offset;
+            chunk->size = len;
+            chunk->address = address + offset;
+            chunk->symbols = symbols;
+            output_init_fragment(&chunk->out, out, offset > 0);
+            
+            if (!pool || thread_pool_submit(pool, disasm_chunk_task, chunk) != SUCCESS) {
+                disasm_chunk_task(chunk);
             }
+            offset += len;
         }
+        thread_pool_wait(pool);
         
-        printf(" %-8s %s\n", insn->mnemonic, insn->op_str);
-        count++;
+        // Chunks cover consecutive address ranges, writing them in order merges the output
+        for (size_t i = 0; i < n; i++) {
+            if (chunks[i].err != SUCCESS) {
+                err = chunks[i].err;
+            } else {
+                output_append(out, &chunks[i].out);
+            }
+            count += chunks[i].count;
+            output_free(&chunks[i].out);
+        }
+    }
+    
+    free(chunks);
+    output_end_array(out);
+    output_uint(out, "count", "Total instructions disassembled", count);
+    output_end_object(out);
+    return err;
+}
+
+// Disassemble the part of every S_ATTR_PURE_INSTRUCTIONS section inside [start, stop),
+// stop 0 means no upper bound. 0 threads means one per CPU.
+macho_error_t disassemble_code_sections(output_t* out, const macho_ctx_t* ctx, cs_arch arch, cs_mode mode,
+                                       uint32_t flags, uint64_t start, uint64_t stop, uint32_t nthreads) {
+    if (!ctx) return ERROR_DISASM_FAILED;
+    if (stop && start >= stop) return ERROR_INVALID_SECTION;
+    
+    const segment_info_t* segments = NULL;
+    uint32_t nsegments = 0;
+    macho_error_t err = get_segments(ctx, &segments, &nsegments);
+    if (err != SUCCESS) return err;
+    
+    // Symbols are optional, stripped binaries are decoded without labels
+    const symbol_index_t* symbols = NULL;
+    if (get_symbol_index(ctx, &symbols) != SUCCESS) symbols = NULL;
+    
+    uint32_t width = fixed_insn_width(arch, mode);
+    thread_pool_t* pool = thread_pool_create(nthreads, 0);
+    uint32_t found = 0;
+    
+    output_begin_array(out, "disassembly", NULL, 0);
+    for (uint32_t i = 0; i < nsegments && err == SUCCESS; i++) {
+        for (uint32_t j = 0; j < segments[i].nsects && err == SUCCESS; j++) {
+            const section_info_t* sect = &segments[i].sections[j];
+            if (!(sect->flags & S_ATTR_PURE_INSTRUCTIONS) || sect->size == 0) continue;
+            
+            // Zero-fill and out-of-file sections have nothing to decode
+            uint32_t type = sect->flags & SECTION_TYPE;
+            if (type == S_ZEROFILL || type == S_GB_ZEROFILL || type == S_THREAD_LOCAL_ZEROFILL) continue;
+            if (sect->offset == 0 || sect->offset > ctx->size || sect->size > ctx->size - sect->offset) {
+                char name[40];
+                snprintf(name, sizeof(name), "%.16s,%.16s", sect->segname, sect->sectname);
+                output_begin_inline(out, "skipped_section", "Skipping");
+                output_str(out, "section", "section", name);
+                output_str(out, "error", "reason", "section data outside the file");
+                output_end_object(out);
+                continue;
+            }
+            
+            // Clip the section to the requested address range
+            uint64_t sect_end = sect->addr + sect->size;
+            uint64_t from = start > sect->addr ? start : sect->addr;
+            uint64_t to = stop && stop < sect_end ? stop : sect_end;
+            if (from >= to) continue;
+            
+            // Keep fixed-width decoding on instruction boundaries
+            if (width) {
+                from -= (from - sect->addr) % width;
+            }
+            
+            char name[40];
+            snprintf(name, sizeof(name), "%.16s,%.16s", sect->segname, sect->sectname);
+            err = disassemble_section_parallel(out, pool, arch, mode, flags, name,
+                                               (const uint8_t*)ctx->data + sect->offset + (from - sect->addr),
+                                               (size_t)(to - from), from, symbols);
+            found++;
+        }
     }
     
-    if (code_size > 0 && count >= max_instructions) {
-        printf("  [Disassembly truncated after %zu instructions]\n", max_instructions);
+    thread_pool_destroy(pool);
+    output_end_array(out);
+    
+    if (found == 0) {
+        output_str(out, "disassembly_error", "Error", "No code found for disassembly");
+        return ERROR_INVALID_SECTION;
     }
+    return err;
+}
+
+// Capstone engine for each supported CPU type
+static const disasm_arch_t disasm_archs[] = {
+    { CPU_TYPE_ARM64, CS_ARCH_AARCH64, CS_MODE_LITTLE_ENDIAN, "arm64" },
+    { CPU_TYPE_ARM64_32, CS_ARCH_AARCH64, CS_MODE_LITTLE_ENDIAN, "arm64_32" },  // A64 ISA, 32-bit pointers
+    { CPU_TYPE_X86_64, CS_ARCH_X86, CS_MODE_64, "x86_64" },
+    { CPU_TYPE_X86, CS_ARCH_X86, CS_MODE_32, "i386" },
+    { CPU_TYPE_ARM, CS_ARCH_ARM, CS_MODE_THUMB, "arm" },                        // Apple armv7 code is Thumb-2
+};
+
+// Look up the Capstone engine for a CPU type
+const disasm_arch_t* find_disasm_arch(cpu_type_t cputype) {
+    for (size_t i = 0; i < sizeof(disasm_archs) / sizeof(disasm_archs[0]); i++) {
+        if (disasm_archs[i].cputype == cputype) {
+            return &disasm_archs[i];
+        }
+    }
+    return NULL;
+}
+
+// Find the address range of a defined symbol: from its value up to the next symbol in the
+// same section, or the end of that section for the last one. Symbols outside any section
+// have no range.
+macho_error_t find_symbol_range(const macho_ctx_t* ctx, const char* name, uint64_t* start, uint64_t* stop) {
+    if (!ctx || !name || !start || !stop) return ERROR_INVALID_SECTION;
     
-    cs_free(insn, 1);
-    printf("--------------------------------------------------------------------------------\n");
-    printf("Total instructions disassembled: %zu\n", count);
+    const symbol_index_t* symbols;
+    uint32_t i;
+    if (get_symbol_index(ctx, &symbols) != SUCCESS || !find_symbol_by_name(symbols, name, &i)) {
+        return ERROR_INVALID_SECTION;
+    }
+    
+    const section_info_t* sect = section_for_ordinal(ctx, symbols->sects[i]);
+    if (!sect || symbols->addresses[i] < sect->addr || symbols->addresses[i] >= sect->addr + sect->size) {
+        return ERROR_INVALID_SECTION;
+    }
     
+    // Sorted by address, so the next symbol of the section is the first one after start
+    *start = symbols->addresses[i];
+    *stop = sect->addr + sect->size;
+    for (uint32_t j = symbol_lower_bound(symbols, *start + 1); j < symbols->count; j++) {
+        if (symbols->sects[j] == symbols->sects[i]) {
+            *stop = symbols->addresses[j];
+            break;
+        }
+    }
     return SUCCESS;
 }
 
-// Disassemble ARM64 code from Mach-O file
-macho_error_t disassemble_macho_arm64(const macho_ctx_t* ctx) {
+// Disassemble with the engine matching the slice CPU type, limited to the requested range
+macho_error_t disassemble_macho(output_t* out, const macho_ctx_t* ctx, const disasm_options_t* opts) {
     if (!ctx) return ERROR_DISASM_FAILED;
     
-    // Check if this is ARM64 architecture
-    if (ctx->cputype != CPU_TYPE_ARM64) {
-        printf("Not an ARM64 binary (CPU type: 0x%x)\n", ctx->cputype);
+    const disasm_arch_t* engine = find_disasm_arch(ctx->cputype);
+    if (!engine) {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "Disassembly not supported for CPU type %s (0x%x)",
+                 get_cpu_type_name(ctx->cputype), ctx->cputype);
+        output_str(out, "disassembly_error", "Error", msg);
         return ERROR_DISASM_FAILED;
     }
     
-    disasm_ctx_t disasm_ctx;
-    macho_error_t err = init_disassembler(&disasm_ctx, CS_ARCH_ARM, CS_MODE_ARM);
-    if (err != SUCCESS) {
-        return err;
-    }
-    
-    // Find and disassemble __text section
-    uint8_t* code = NULL;
-    size_t code_size = 0;
-    uint64_t code_addr = 0;
+    disasm_options_t defaults = {0};
+    if (!opts) opts = &defaults;
     
-    err = find_text_section(ctx, &code, &code_size, &code_addr);
-    if (err == SUCCESS) {
-        disassemble_section(&disasm_ctx, "__text", code, code_size, code_addr);
-        free(code);
-    } else {
-        printf("Could not find __text section for disassembly\n");
+    uint64_t start = opts->start_address;
+    uint64_t stop = opts->stop_address;
+    if (opts->symbol) {
+        if (find_symbol_range(ctx, opts->symbol, &start, &stop) != SUCCESS) {
+            output_str(out, "disassembly_error", "Error", "Symbol not found in any section");
+            return ERROR_INVALID_SECTION;
+        }
+        output_begin_inline(out, "symbol_range", "Symbol");
+        output_str(out, "name", "name", opts->symbol);
+        output_hex(out, "start", "start", start);
+        output_hex(out, "stop", "stop", stop);
+        output_end_object(out);
     }
     
-    free_disassembler(&disasm_ctx);
-    return err;
+    output_str(out, "disassembler", "Disassembling as", engine->name);
+    return disassemble_code_sections(out, ctx, engine->arch, engine->mode, opts->flags,
+                                     start, stop, opts->nthreads);
 
 }
-
-
@@ -0,0 +1,831 @@
+/*
+* dyldinfo.c
+* Coded by iosmen (c) 2025
+*/
+#include "../include/macho.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Read a ULEB128, p stops at end on truncation and *ok is cleared
+static uint64_t read_uleb128(const uint8_t** p, const uint8_t* end, int* ok) {
+    uint64_t result = 0;
+    uint32_t shift = 0;
+    while (*p < end) {
+        uint8_t byte = *(*p)++;
+        if (shift < 64) result |= (uint64_t)(byte & 0x7f) << shift;
+        shift += 7;
+        if (!(byte & 0x80)) return result;
+    }
+    *ok = 0;
+    return 0;
+}
+
+static int64_t read_sleb128(const uint8_t** p, const uint8_t* end, int* ok) {
+    int64_t result = 0;
+    uint32_t shift = 0;
+    while (*p < end) {
+        uint8_t byte = *(*p)++;
+        if (shift < 64) result |= (int64_t)((uint64_t)(byte & 0x7f) << shift);
+        shift += 7;
+        if (!(byte & 0x80)) {
+            if (shift < 64 && (byte & 0x40)) result |= -((int64_t)1 << shift);
+            return result;
+        }
+    }
+    *ok = 0;
+    return 0;
+}
+
+// Start decoding one opcode stream of LC_DYLD_INFO(_ONLY)
+macho_error_t dyld_info_iter_init(dyld_info_iter_t* iter, const macho_ctx_t* ctx, dyld_info_kind_t kind) {
+    if (!iter) return ERROR_READ_FAILED;
+    memset(iter, 0, sizeof(dyld_info_iter_t));
+    iter->kind = kind;
+    iter->done = 1;
+    if (!ctx) return ERROR_READ_FAILED;
+    
+    const load_command_t* lc = ctx->lc_index.dyld_info;
+    if (!lc) return ERROR_INVALID_SECTION;
+    
+    const struct dyld_info_command* info = (const struct dyld_info_command*)lc->data;
+    uint32_t off, size;
+    switch (kind) {
+        case DYLD_INFO_REBASE: off = info->rebase_off; size = info->rebase_size; break;
+        case DYLD_INFO_BIND: off = info->bind_off; size = info->bind_size; break;
+        case DYLD_INFO_WEAK_BIND: off = info->weak_bind_off; size = info->weak_bind_size; break;
+        default: off = info->lazy_bind_off; size = info->lazy_bind_size; break;
+    }
+    if (ctx->is_swap) {
+        off = swap32(off);
+        size = swap32(size);
+    }
+    if ((uint64_t)off + size > ctx->size) return ERROR_INVALID_SECTION;
+    
+    macho_error_t err = get_segments(ctx, &iter->segments, &iter->nsegments);
+    if (err != SUCCESS) return err;
+    if (kind != DYLD_INFO_REBASE) {
+        err = find_dylib_dependencies(ctx, &iter->dylibs, &iter->ndylibs);
+        if (err != SUCCESS) return err;
+    }
+    
+    iter->p = (const uint8_t*)ctx->data + off;
+    iter->end = iter->p + size;
+    iter->pointer_size = ctx->is_64bit ? 8 : 4;
+    iter->type = kind == DYLD_INFO_REBASE ? REBASE_TYPE_POINTER : BIND_TYPE_POINTER;
+    iter->done = size == 0;
+    return SUCCESS;
+}
+
+void dyld_info_iter_free(dyld_info_iter_t* iter) {
+    if (!iter) return;
+    
+    for (uint32_t i = 0; i < iter->ndylibs; i++) {
+        free(iter->dylibs[i]);
+    }
+    free(iter->dylibs);
+    iter->dylibs = NULL;
+    iter->ndylibs = 0;
+    iter->done = 1;
+}
+
+static int iter_fail(dyld_info_iter_t* iter) {
+    iter->err = ERROR_INVALID_SECTION;
+    iter->done = 1;
+    return 0;
+}
+
+// Emit the record at the current position and advance by step
+static int iter_emit(dyld_info_iter_t* iter, dyld_info_record_t* record) {
+    if (iter->segment >= iter->nsegments) return iter_fail(iter);
+    
+    // Out-of-segment addresses also stop runaway DO_*_TIMES counts
+    const segment_info_t* seg = &iter->segments[iter->segment];
+    if (iter->offset >= seg->vmsize) return iter_fail(iter);
+    
+    memset(record, 0, sizeof(dyld_info_record_t));
+    record->kind = iter->kind;
+    record->segment = iter->segment;
+    record->segment_offset = iter->offset;
+    record->address = seg->vmaddr + iter->offset;
+    record->type = iter->type;
+    if (iter->kind != DYLD_INFO_REBASE) {
+        record->flags = iter->flags;
+        record->lib_ordinal = iter->lib_ordinal;
+        record->addend = iter->addend;
+        record->symbol = iter->symbol;
+        if (iter->kind != DYLD_INFO_WEAK_BIND) {
+            record->dylib = get_dylib_ordinal_name(iter->dylibs, iter->ndylibs, iter->lib_ordinal);
+        }
+    }
+    
+    iter->offset += iter->step;
+    iter->pending--;
+    return 1;
+}
+
+static int next_rebase(dyld_info_iter_t* iter, dyld_info_record_t* record) {
+    int ok = 1;
+    while (iter->p < iter->end) {
+        uint8_t byte = *iter->p++;
+        uint8_t imm = byte & REBASE_IMMEDIATE_MASK;
+        
+        switch (byte & REBASE_OPCODE_MASK) {
+            case REBASE_OPCODE_DONE:
+                iter->done = 1;
+                return 0;
+            case REBASE_OPCODE_SET_TYPE_IMM:
+                iter->type = imm;
+                break;
+            case REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB:
+                iter->segment = imm;
+                iter->offset = read_uleb128(&iter->p, iter->end, &ok);
+                break;
+            case REBASE_OPCODE_ADD_ADDR_ULEB:
+                iter->offset += read_uleb128(&iter->p, iter->end, &ok);
+                break;
+            case REBASE_OPCODE_ADD_ADDR_IMM_SCALED:
+                iter->offset += (uint64_t)imm * iter->pointer_size;
+                break;
+            case REBASE_OPCODE_DO_REBASE_IMM_TIMES:
+                iter->pending = imm;
+                iter->step = iter->pointer_size;
+                break;
+            case REBASE_OPCODE_DO_REBASE_ULEB_TIMES:
+                iter->pending = read_uleb128(&iter->p, iter->end, &ok);
+                iter->step = iter->pointer_size;
+                break;
+            case REBASE_OPCODE_DO_REBASE_ADD_ADDR_ULEB:
+                iter->pending = 1;
+                iter->step = read_uleb128(&iter->p, iter->end, &ok) + iter->pointer_size;
+                break;
+            case REBASE_OPCODE_DO_REBASE_ULEB_TIMES_SKIPPING_ULEB:
+                iter->pending = read_uleb128(&iter->p, iter->end, &ok);
+                iter->step = read_uleb128(&iter->p, iter->end, &ok) + iter->pointer_size;
+                break;
+            default:
+                return iter_fail(iter);
+        }
+        
+        if (!ok) return iter_fail(iter);
+        if (iter->pending > 0) return iter_emit(iter, record);
+    }
+    
+    iter->done = 1;
+    return 0;
+}
+
+static int next_bind(dyld_info_iter_t* iter, dyld_info_record_t* record) {
+    int ok = 1;
+    while (iter->p < iter->end) {
+        uint8_t byte = *iter->p++;
+        uint8_t imm = byte & BIND_IMMEDIATE_MASK;
+        
+        switch (byte & BIND_OPCODE_MASK) {
+            case BIND_OPCODE_DONE:
+                // Lazy binds are separate entries, each ends with DONE
+                if (iter->kind == DYLD_INFO_LAZY_BIND) break;
+                iter->done = 1;
+                return 0;
+            case BIND_OPCODE_SET_DYLIB_ORDINAL_IMM:
+                iter->lib_ordinal = imm;
+                break;
+            case BIND_OPCODE_SET_DYLIB_ORDINAL_ULEB:
+                iter->lib_ordinal = (int32_t)read_uleb128(&iter->p, iter->end, &ok);
+                break;
+            case BIND_OPCODE_SET_DYLIB_SPECIAL_IMM:
+                iter->lib_ordinal = imm == 0 ? 0 : (int32_t)(int8_t)(BIND_OPCODE_MASK | imm);
+                break;
+            case BIND_OPCODE_SET_SYMBOL_TRAILING_FLAGS_IMM: {
+                const uint8_t* nul = memchr(iter->p, '\0', (size_t)(iter->end - iter->p));
+                if (!nul) return iter_fail(iter);
+                iter->flags = imm;
+                iter->symbol = (const char*)iter->p;
+                iter->p = nul + 1;
+                break;
+            }
+            case BIND_OPCODE_SET_TYPE_IMM:
+                iter->type = imm;
+                break;
+            case BIND_OPCODE_SET_ADDEND_SLEB:
+                iter->addend = read_sleb128(&iter->p, iter->end, &ok);
+                break;
+            case BIND_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB:
+                iter->segment = imm;
+                iter->offset = read_uleb128(&iter->p, iter->end, &ok);
+                break;
+            case BIND_OPCODE_ADD_ADDR_ULEB:
+                iter->offset += read_uleb128(&iter->p, iter->end, &ok);
+                break;
+            case BIND_OPCODE_DO_BIND:
+                iter->pending = 1;
+                iter->step = iter->pointer_size;
+                break;
+            case BIND_OPCODE_DO_BIND_ADD_ADDR_ULEB:
+                iter->pending = 1;
+                iter->step = read_uleb128(&iter->p, iter->end, &ok) + iter->pointer_size;
+                break;
+            case BIND_OPCODE_DO_BIND_ADD_ADDR_IMM_SCALED:
+                iter->pending = 1;
+                iter->step = (uint64_t)imm * iter->pointer_size + iter->pointer_size;
+                break;
+            case BIND_OPCODE_DO_BIND_ULEB_TIMES_SKIPPING_ULEB:
+                iter->pending = read_uleb128(&iter->p, iter->end, &ok);
+                iter->step = read_uleb128(&iter->p, iter->end, &ok) + iter->pointer_size;
+                break;
+            default:
+                // Includes BIND_OPCODE_THREADED, superseded by chained fixups
+                return iter_fail(iter);
+        }
+        
+        if (!ok) return iter_fail(iter);
+        if (iter->pending > 0) {
+            if (!iter->symbol) return iter_fail(iter);
+            return iter_emit(iter, record);
+        }
+    }
+    
+    iter->done = 1;
+    return 0;
+}
+
+// Produce the next record, 0 at the end of the stream or on error (iter->err)
+int dyld_info_iter_next(dyld_info_iter_t* iter, dyld_info_record_t* record) {
+    if (!iter || !record || iter->done) return 0;
+    
+    if (iter->pending > 0) return iter_emit(iter, record);
+    if (iter->kind == DYLD_INFO_REBASE) return next_rebase(iter, record);
+    return next_bind(iter, record);
+}
+
+// Locate the export trie: LC_DYLD_EXPORTS_TRIE, else the one in LC_DYLD_INFO
+macho_error_t find_export_trie(const macho_ctx_t* ctx, const uint8_t** trie, uint32_t* size) {
+    if (!ctx || !trie || !size) return ERROR_READ_FAILED;
+    *trie = NULL;
+    *size = 0;
+    
+    uint32_t off = 0, len = 0;
+    if (ctx->lc_index.exports_trie) {
+        macho_error_t err = find_linkedit_data(ctx, LC_DYLD_EXPORTS_TRIE, &off, &len);
+        if (err != SUCCESS) return err;
+    } else if (ctx->lc_index.dyld_info) {
+        const struct dyld_info_command* info = (const struct dyld_info_command*)ctx->lc_index.dyld_info->data;
+        off = ctx->is_swap ? swap32(info->export_off) : info->export_off;
+        len = ctx->is_swap ? swap32(info->export_size) : info->export_size;
+        if ((uint64_t)off + len > ctx->size) return ERROR_INVALID_SECTION;
+    }
+    if (len == 0) return ERROR_INVALID_SECTION;
+    
+    *trie = (const uint8_t*)ctx->data + off;
+    *size = len;
+    return SUCCESS;
+}
+
+// Pending trie node: its offset, the edge label leading to it and the length of the
+// parent's name. Depth-first order keeps the parent's prefix intact in the name buffer.
+typedef struct {
+    uint64_t node;
+    uint32_t label;             // Trie offset of the NUL-terminated edge label
+    uint32_t label_len;
+    size_t parent_len;
+} trie_frame_t;
+
+// Decode the terminal info of a node, name is filled in by the caller
+static int read_export_info(const uint8_t* p, const uint8_t* info_end, uint64_t image_base,
+                            export_entry_t* entry) {
+    int ok = 1;
+    memset(entry, 0, sizeof(export_entry_t));
+    entry->flags = read_uleb128(&p, info_end, &ok);
+    if (entry->flags & EXPORT_SYMBOL_FLAGS_REEXPORT) {
+        entry->reexport_ordinal = read_uleb128(&p, info_end, &ok);
+        const uint8_t* nul = p < info_end ? memchr(p, '\0', (size_t)(info_end - p)) : NULL;
+        entry->import_name = nul ? (const char*)p : "";
+        return ok && nul;
+    }
+    
+    uint64_t value = read_uleb128(&p, info_end, &ok);
+    uint64_t kind = entry->flags & EXPORT_SYMBOL_FLAGS_KIND_MASK;
+    entry->address = kind == EXPORT_SYMBOL_FLAGS_KIND_ABSOLUTE ? value : image_base + value;
+    if (entry->flags & EXPORT_SYMBOL_FLAGS_STUB_AND_RESOLVER) {
+        entry->resolver = image_base + read_uleb128(&p, info_end, &ok);
+    }
+    return ok;
+}
+
+// Split a node into its terminal info and child list, 0 when malformed
+static int read_export_node(const uint8_t* trie, uint32_t size, uint64_t node, const uint8_t** info,
+                            const uint8_t** info_end, const uint8_t** children, uint8_t* nchildren) {
+    if (node >= size) return 0;
+    
+    int ok = 1;
+    const uint8_t* end = trie + size;
+    const uint8_t* p = trie + node;
+    uint64_t terminal_size = read_uleb128(&p, end, &ok);
+    if (!ok || terminal_size >= (uint64_t)(end - p)) return 0;
+    
+    *info = p;
+    *info_end = p + terminal_size;
+    *nchildren = *(*info_end);
+    *children = *info_end + 1;
+    return 1;
+}
+
+// Read the next child edge: its label and the child node offset
+static int read_export_edge(const uint8_t** p, const uint8_t* end, const uint8_t** label,
+                            size_t* label_len, uint64_t* child) {
+    const uint8_t* nul = *p < end ? memchr(*p, '\0', (size_t)(end - *p)) : NULL;
+    if (!nul) return 0;
+    
+    int ok = 1;
+    *label = *p;
+    *label_len = (size_t)(nul - *p);
+    *p = nul + 1;
+    *child = read_uleb128(p, end, &ok);
+    return ok;
+}
+
+// Follow edges matching name from the root. Exact mode stops at the node named name;
+// prefix mode stops at the first node whose name starts with name, which may sit
+// in the middle of an edge. Touches one path of the trie only.
+static macho_error_t descend_export_trie(const uint8_t* trie, uint32_t size, const char* name, size_t len,
+                                         int prefix, trie_frame_t* frame, int* found) {
+    uint64_t node = 0;
+    size_t consumed = 0;
+    *found = 0;
+    memset(frame, 0, sizeof(trie_frame_t));
+    
+    for (uint32_t steps = 0; steps <= size; steps++) {
+        if (consumed == len) {
+            frame->node = node;
+            frame->parent_len = consumed;
+            *found = 1;
+            return SUCCESS;
+        }
+        
+        const uint8_t *info, *info_end, *p;
+        uint8_t nchildren;
+        if (!read_export_node(trie, size, node, &info, &info_end, &p, &nchildren)) {
+            return ERROR_INVALID_SECTION;
+        }
+        
+        size_t remaining = len - consumed;
+        int descended = 0;
+        for (uint8_t i = 0; i < nchildren && !descended; i++) {
+            const uint8_t* label;
+            size_t label_len;
+            uint64_t child;
+            if (!read_export_edge(&p, trie + size, &label, &label_len, &child)) {
+                return ERROR_INVALID_SECTION;
+            }
+            
+            if (prefix && label_len >= remaining && memcmp(label, name + consumed, remaining) == 0) {
+                frame->node = child;
+                frame->label = (uint32_t)(label - trie);
+                frame->label_len = (uint32_t)label_len;
+                frame->parent_len = consumed;
+                *found = 1;
+                return SUCCESS;
+            }
+            if (label_len > 0 && label_len <= remaining && memcmp(label, name + consumed, label_len) == 0) {
+                node = child;
+                consumed += label_len;
+                descended = 1;
+            }
+        }
+        if (!descended) return SUCCESS;
+    }
+    return ERROR_INVALID_SECTION;
+}
+
+// Depth-first walk from one node with an explicit stack. The name buffer starts with
+// the first parent_len bytes of prefix. Like dyld, a node reached twice means the trie
+// loops and is rejected, and names are capped at EXPORT_NAME_MAX.
+static macho_error_t walk_export_subtree(const uint8_t* trie, uint32_t size, uint64_t image_base,
+                                         const trie_frame_t* start, const char* prefix,
+                                         export_fn fn, void* arg) {
+    const uint8_t* end = trie + size;
+    if (start->parent_len > EXPORT_NAME_MAX) return ERROR_INVALID_SECTION;
+    
+    char* name = malloc(EXPORT_NAME_MAX + 1);
+    uint8_t* visited = calloc(((size_t)size + 7) / 8, 1);  // One bit per trie offset
+    size_t stack_cap = 64;
+    size_t depth = 0;
+    trie_frame_t* stack = malloc(stack_cap * sizeof(trie_frame_t));
+    if (!name || !visited || !stack) {
+        free(name);
+        free(visited);
+        free(stack);
+        return ERROR_READ_FAILED;
+    }
+    
+    memcpy(name, prefix, start->parent_len);
+    stack[depth++] = *start;
+    
+    macho_error_t err = SUCCESS;
+    int stop = 0;
+    while (depth > 0 && !stop && err == SUCCESS) {
+        trie_frame_t frame = stack[--depth];
+        
+        // Offsets past the end fail in read_export_node below
+        if (frame.node < size) {
+            if (visited[frame.node / 8] & (1u << (frame.node % 8))) {
+                err = ERROR_INVALID_SECTION;
+                break;
+            }
+            visited[frame.node / 8] |= (uint8_t)(1u << (frame.node % 8));
+        }
+        
+        // Name of this node: the parent's name plus the edge label
+        size_t name_len = frame.parent_len + frame.label_len;
+        if (name_len > EXPORT_NAME_MAX) {
+            err = ERROR_INVALID_SECTION;
+            break;
+        }
+        memcpy(name + frame.parent_len, trie + frame.label, frame.label_len);
+        name[name_len] = '\0';
+        
+        const uint8_t *info, *info_end, *p;
+        uint8_t nchildren;
+        if (!read_export_node(trie, size, frame.node, &info, &info_end, &p, &nchildren)) {
+            err = ERROR_INVALID_SECTION;
+            break;
+        }
+        
+        if (info_end > info) {
+            export_entry_t entry;
+            if (!read_export_info(info, info_end, image_base, &entry)) {
+                err = ERROR_INVALID_SECTION;
+                break;
+            }
+            entry.name = name;
+            if (fn && fn(&entry, arg)) {
+                stop = 1;
+                break;
+            }
+        }
+        
+        // Children are pushed in trie order, then reversed so they pop in that order
+        size_t first = depth;
+        for (uint8_t i = 0; i < nchildren; i++) {
+            const uint8_t* label;
+            size_t label_len;
+            uint64_t child;
+            if (!read_export_edge(&p, end, &label, &label_len, &child)) {
+                err = ERROR_INVALID_SECTION;
+                break;
+            }
+            
+            if (depth == stack_cap) {
+                trie_frame_t* grown = realloc(stack, stack_cap * 2 * sizeof(trie_frame_t));
+                if (!grown) {
+                    err = ERROR_READ_FAILED;
+                    break;
+                }
+                stack = grown;
+                stack_cap *= 2;
+            }
+            stack[depth].node = child;
+            stack[depth].label = (uint32_t)(label - trie);
+            stack[depth].label_len = (uint32_t)label_len;
+            stack[depth].parent_len = name_len;
+            depth++;
+        }
+        for (size_t lo = first, hi = depth; lo + 1 < hi; lo++, hi--) {
+            trie_frame_t tmp = stack[lo];
+            stack[lo] = stack[hi - 1];
+            stack[hi - 1] = tmp;
+        }
+    }
+    
+    free(name);
+    free(visited);
+    free(stack);
+    return err;
+}
+
+// Visit every export in trie order
+macho_error_t walk_export_trie(const macho_ctx_t* ctx, export_fn fn, void* arg) {
+    return walk_export_prefix(ctx, "", fn, arg);
+}
+
+// Visit the exports whose names start with prefix, only their subtree is read
+macho_error_t walk_export_prefix(const macho_ctx_t* ctx, const char* prefix, export_fn fn, void* arg) {
+    const uint8_t* trie;
+    uint32_t size;
+    if (!prefix) return ERROR_READ_FAILED;
+    macho_error_t err = find_export_trie(ctx, &trie, &size);
+    if (err != SUCCESS) return err;
+    
+    trie_frame_t start;
+    int found;
+    err = descend_export_trie(trie, size, prefix, strlen(prefix), 1, &start, &found);
+    if (err != SUCCESS || !found) return err;
+    
+    return walk_export_subtree(trie, size, get_image_base(ctx), &start, prefix, fn, arg);
+}
+
+// Exact lookup straight on the trie, *found is cleared when the name is not exported
+macho_error_t find_export(const macho_ctx_t* ctx, const char* name, export_entry_t* entry, int* found) {
+    const uint8_t* trie;
+    uint32_t size;
+    if (!name || !entry || !found) return ERROR_READ_FAILED;
+    *found = 0;
+    macho_error_t err = find_export_trie(ctx, &trie, &size);
+    if (err != SUCCESS) return err;
+    
+    trie_frame_t frame;
+    int reached;
+    err = descend_export_trie(trie, size, name, strlen(name), 0, &frame, &reached);
+    if (err != SUCCESS || !reached) return err;
+    
+    const uint8_t *info, *info_end, *children;
+    uint8_t nchildren;
+    if (!read_export_node(trie, size, frame.node, &info, &info_end, &children, &nchildren)) {
+        return ERROR_INVALID_SECTION;
+    }
+    if (info_end == info) return SUCCESS;
+    if (!read_export_info(info, info_end, get_image_base(ctx), entry)) return ERROR_INVALID_SECTION;
+    
+    entry->name = name;
+    *found = 1;
+    return SUCCESS;
+}
+
+// Growing state while flattening the trie
+typedef struct {
+    export_list_t* list;
+    uint32_t cap;
+    size_t* name_offsets;       // Names live in the arena, pointers are set once it stops moving
+    strbuf_t names;
+    int failed;
+} export_list_builder_t;
+
+static int collect_export(const export_entry_t* entry, void* arg) {
+    export_list_builder_t* builder = (export_list_builder_t*)arg;
+    export_list_t* list = builder->list;
+    
+    if (list->count == builder->cap) {
+        uint32_t cap = builder->cap ? builder->cap * 2 : 256;
+        export_entry_t* entries = realloc(list->entries, cap * sizeof(export_entry_t));
+        size_t* offsets = realloc(builder->name_offsets, cap * sizeof(size_t));
+        if (entries) list->entries = entries;
+        if (offsets) builder->name_offsets = offsets;
+        if (!entries || !offsets) {
+            builder->failed = 1;
+            return 1;
+        }
+        builder->cap = cap;
+    }
+    
+    size_t offset = builder->names.len;
+    size_t len = strlen(entry->name);
+    strbuf_append(&builder->names, entry->name, len + 1);
+    if (builder->names.len != offset + len + 1) {
+        builder->failed = 1;
+        return 1;
+    }
+    builder->name_offsets[list->count] = offset;
+    list->entries[list->count++] = *entry;
+    return 0;
+}
+
+static int compare_exports(const void* a, const void* b) {
+    return strcmp(((const export_entry_t*)a)->name, ((const export_entry_t*)b)->name);
+}
+
+// Flatten the trie into one array sorted by name, names are packed in a single arena
+// so the cost stays linear in the total name length
+macho_error_t build_export_list(const macho_ctx_t* ctx, export_list_t* list) {
+    if (!list) return ERROR_READ_FAILED;
+    memset(list, 0, sizeof(export_list_t));
+    
+    export_list_builder_t builder;
+    memset(&builder, 0, sizeof(builder));
+    builder.list = list;
+    strbuf_init(&builder.names);
+    
+    macho_error_t err = walk_export_trie(ctx, collect_export, &builder);
+    if (err == SUCCESS && builder.failed) {
+        err = ERROR_READ_FAILED;
+    }
+    if (err != SUCCESS) {
+        free(builder.name_offsets);
+        strbuf_free(&builder.names);
+        free_export_list(list);
+        return err;
+    }
+    
+    list->names = builder.names.data;
+    for (uint32_t i = 0; i < list->count; i++) {
+        list->entries[i].name = list->names + builder.name_offsets[i];
+    }
+    free(builder.name_offsets);
+    
+    qsort(list->entries, list->count, sizeof(export_entry_t), compare_exports);
+    return SUCCESS;
+}
+
+void free_export_list(export_list_t* list) {
+    if (!list) return;
+    
+    free(list->entries);
+    free(list->names);
+    memset(list, 0, sizeof(export_list_t));
+}
+
+static const char* const dyld_info_keys[] = { "rebase", "bind", "weak_bind", "lazy_bind" };
+static const char* const dyld_info_labels[] = { "Rebases", "Binds", "Weak Binds", "Lazy Binds" };
+
+// Stream one opcode table, one record per pointer
+static void print_dyld_info_table(output_t* out, const macho_ctx_t* ctx, dyld_info_kind_t kind) {
+    dyld_info_iter_t iter;
+    macho_error_t err = dyld_info_iter_init(&iter, ctx, kind);
+    
+    output_begin_object(out, "dyld_info_table", dyld_info_labels[kind]);
+    output_str(out, "table", NULL, dyld_info_keys[kind]);
+    
+    // A stream outside the file has nothing to decode, say why instead of an empty table
+    if (err != SUCCESS) {
+        output_str(out, "error", "Error", macho_strerror(err));
+        output_end_object(out);
+        dyld_info_iter_free(&iter);
+        return;
+    }
+    output_begin_stream(out, "entries", NULL, 0);
+    
+    uint64_t count = 0;
+    dyld_info_record_t record;
+    while (dyld_info_iter_next(&iter, &record)) {
+        char label[24];
+        snprintf(label, sizeof(label), "0x%llx", (unsigned long long)record.address);
+        output_begin_inline(out, dyld_info_keys[kind], label);
+        output_hex(out, "address", NULL, record.address);
+        output_uint(out, "segment", NULL, record.segment);
+        output_hex(out, "segment_offset", NULL, record.segment_offset);
+        if (kind == DYLD_INFO_REBASE) {
+            output_uint(out, "rebase_type", "type", record.type);
+        } else {
+            output_str(out, "symbol", "", record.symbol);
+            if (record.dylib) {
+                output_str(out, "dylib", "dylib", record.dylib);
+            }
+            if (record.addend != 0) {
+                output_hex(out, "addend", "addend", (uint64_t)record.addend);
+            }
+            if (record.flags & BIND_SYMBOL_FLAGS_WEAK_IMPORT) {
+                output_bool(out, "weak_import", "weak_import", 1);
+            }
+            if (record.flags & BIND_SYMBOL_FLAGS_NON_WEAK_DEFINITION) {
+                output_bool(out, "non_weak_definition", "non_weak_definition", 1);
+            }
+        }
+        output_end_object(out);
+        count++;
+    }
+    output_end_array(out);
+    
+    if (iter.err != SUCCESS) {
+        output_str(out, "error", "Error", macho_strerror(iter.err));
+    }
+    output_uint(out, "count", "Total", count);
+    output_end_object(out);
+    dyld_info_iter_free(&iter);
+}
+
+// Short description of export flags
+static const char* export_kind_name(uint64_t flags) {
+    if (flags & EXPORT_SYMBOL_FLAGS_REEXPORT) return "reexport";
+    if (flags & EXPORT_SYMBOL_FLAGS_STUB_AND_RESOLVER) return "resolver";
+    switch (flags & EXPORT_SYMBOL_FLAGS_KIND_MASK) {
+        case EXPORT_SYMBOL_FLAGS_KIND_THREAD_LOCAL: return "thread_local";
+        case EXPORT_SYMBOL_FLAGS_KIND_ABSOLUTE: return "absolute";
+        default: return "regular";
+    }
+}
+
+static int print_export(const export_entry_t* entry, void* arg) {
+    output_t* out = (output_t*)arg;
+    
+    output_begin_inline(out, "export", entry->name);
+    output_str(out, "name", NULL, entry->name);
+    if (entry->flags & EXPORT_SYMBOL_FLAGS_REEXPORT) {
+        output_uint(out, "reexport_ordinal", "ordinal", entry->reexport_ordinal);
+        if (entry->import_name && entry->import_name[0]) {
+            output_str(out, "import_name", "as", entry->import_name);
+        }
+    } else {
+        output_hex(out, "address", "address", entry->address);
+    }
+    if (entry->flags & EXPORT_SYMBOL_FLAGS_STUB_AND_RESOLVER) {
+        output_hex(out, "resolver", "resolver", entry->resolver);
+    }
+    output_str(out, "kind", "kind", export_kind_name(entry->flags));
+    if (entry->flags & EXPORT_SYMBOL_FLAGS_WEAK_DEFINITION) {
+        output_bool(out, "weak", "weak", 1);
+    }
+    output_end_object(out);
+    return 0;
+}
+
+// Prints each export while counting them
+typedef struct {
+    output_t* out;
+    uint64_t count;
+} count_exports_t;
+
+static int count_export(const export_entry_t* entry, void* arg) {
+    count_exports_t* counter = (count_exports_t*)arg;
+    print_export(entry, counter->out);
+    counter->count++;
+    return 0;
+}
+
+// Print the export trie in trie order
+void print_exports(output_t* out, const macho_ctx_t* ctx) {
+    output_begin_object(out, "exports", "Exports");
+    output_begin_stream(out, "entries", NULL, 0);
+    macho_error_t err = walk_export_trie(ctx, print_export, out);
+    output_end_array(out);
+    if (err != SUCCESS) {
+        output_str(out, "error", "Error", macho_strerror(err));
+    }
+    output_end_object(out);
+}
+
+// Sorted export list, or in trie order the exports starting with prefix
+void print_export_list(output_t* out, const macho_ctx_t* ctx, const char* prefix) {
+    macho_error_t err;
+    uint64_t count = 0;
+    
+    output_begin_object(out, "exports", "Exports");
+    if (prefix) {
+        output_str(out, "prefix", "Prefix", prefix);
+    }
+    output_begin_stream(out, "entries", NULL, 0);
+    if (prefix) {
+        count_exports_t counter = { out, 0 };
+        err = walk_export_prefix(ctx, prefix, count_export, &counter);
+        count = counter.count;
+    } else {
+        export_list_t list;
+        err = build_export_list(ctx, &list);
+        for (uint32_t i = 0; i < list.count; i++) {
+            print_export(&list.entries[i], out);
+        }
+        count = list.count;
+        free_export_list(&list);
+    }
+    output_end_array(out);
+    
+    if (err != SUCCESS) {
+        output_str(out, "error", "Error", macho_strerror(err));
+    }
+    output_uint(out, "count", "Total", count);
+    output_end_object(out);
+}
+
+// Exact lookups answered from the trie without expanding it
+void print_export_lookups(output_t* out, const macho_ctx_t* ctx, char* const* names, uint32_t count) {
+    output_begin_array(out, "export_lookups", "Export lookups", count);
+    for (uint32_t i = 0; i < count; i++) {
+        export_entry_t entry;
+        int found = 0;
+        macho_error_t err = find_export(ctx, names[i], &entry, &found);
+        if (found) {
+            print_export(&entry, out);
+            continue;
+        }
+        
+        output_begin_inline(out, "export", names[i]);
+        output_str(out, "name", NULL, names[i]);
+        output_str(out, "error", "", err == SUCCESS ? "not exported" : macho_strerror(err));
+        output_end_object(out);
+    }
+    output_end_array(out);
+}
+
+// Print every LC_DYLD_INFO opcode table and the exports
+void print_dyld_info(output_t* out, const macho_ctx_t* ctx) {
+    const load_command_t* lc = ctx ? ctx->lc_index.dyld_info : NULL;
+    if (!lc) {
+        output_str(out, "dyld_info_error", "Dyld Info", "None");
+        if (ctx && ctx->lc_index.exports_trie) {
+            print_exports(out, ctx);
+        }
+        return;
+    }
+    
+    const struct dyld_info_command* info = (const struct dyld_info_command*)lc->data;
+    output_begin_object(out, "dyld_info", "Dyld Info");
+    output_uint(out, "rebase_size", "Rebase size", ctx->is_swap ? swap32(info->rebase_size) : info->rebase_size);
+    output_uint(out, "bind_size", "Bind size", ctx->is_swap ? swap32(info->bind_size) : info->bind_size);
+    output_uint(out, "weak_bind_size", "Weak bind size", ctx->is_swap ? swap32(info->weak_bind_size) : info->weak_bind_size);
+    output_uint(out, "lazy_bind_size", "Lazy bind size", ctx->is_swap ? swap32(info->lazy_bind_size) : info->lazy_bind_size);
+    output_uint(out, "export_size", "Export size", ctx->is_swap ? swap32(info->export_size) : info->export_size);
+    output_end_object(out);
+    
+    for (int kind = DYLD_INFO_REBASE; kind <= DYLD_INFO_LAZY_BIND; kind++) {
+        print_dyld_info_table(out, ctx, (dyld_info_kind_t)kind);
+    }
+    print_exports(out, ctx);
+
+}
@@ -8,112 +8,217 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
 
-// Find entitlements in code signature
-macho_error_t find_entitlements_blob(const macho_ctx_t* ctx, uint32_t* offset, uint32_t* size) {
+// Find an entitlements blob in the code signature, offset and size cover its payload
+static macho_error_t find_entitlements_blob(const macho_ctx_t* ctx, uint32_t type, uint32_t magic,
+                                            uint32_t* offset, uint32_t* size) {
     if (!ctx || !offset || !size) return ERROR_READ_FAILED;
     
-    uint32_t cs_offset, cs_size;
-    macho_error_t err = find_code_signature(ctx, &cs_offset, &cs_size);
+    const cs_signature_t* signature;
+    macho_error_t err = get_code_signature(ctx, &signature);
     if (err != SUCCESS) {
         return err;
     }
     
-    // Parse SuperBlob to find entitlements
-    CS_SuperBlob* superblob = (CS_SuperBlob*)((char*)ctx->data + cs_offset);
-    uint32_t count = ctx->is_swap ? swap32(superblob->count) : superblob->count;
-    
-    for (uint32_t i = 0; i < count; i++) {
-        CS_BlobIndex* index = &superblob->index[i];
-        uint32_t blob_type = ctx->is_swap ? swap32(index->type) : index->type;
-        uint32_t blob_offset = ctx->is_swap ? swap32(index->offset) : index->offset;
-        
-        if (blob_type == 5) { // Entitlements blob type
-            struct __Blob {
-                uint32_t magic;
-                uint32_t length;
-            } *blob = (struct __Blob*)((char*)superblob + blob_offset);
-            
-            uint32_t blob_magic = ctx->is_swap ? swap32(blob->magic) : blob->magic;
-            if (blob_magic == 0xfade7171) { // CSMAGIC_EMBEDDED_ENTITLEMENTS
-                *offset = cs_offset + blob_offset + 8; // Skip magic and length
-                *size = (ctx->is_swap ? swap32(blob->length) : blob->length) - 8;
-                return SUCCESS;
-            }
-        }
+    // The index only hands out blobs that fit in the signature
+    const cs_blob_t* blob = cs_find_blob(signature, type, magic);
+    if (!blob) {
+        return ERROR_NO_CODE_SIGNATURE;
     }
     
-    return ERROR_NO_CODE_SIGNATURE;
+    *offset = signature->offset + blob->offset + 8; // Skip magic and length
+    *size = blob->blob.size - 8;
+    return SUCCESS;
 }
 
 // Parse entitlements from Mach-O file
 macho_error_t parse_entitlements(const macho_ctx_t* ctx, entitlements_t** entitlements) {
     if (!ctx || !entitlements) return ERROR_READ_FAILED;
     
-    uint32_t entitlements_offset, entitlements_size;
-    macho_error_t err = find_entitlements_blob(ctx, &entitlements_offset, &entitlements_size);
-    if (err != SUCCESS) {
-        printf("Entitlements: Not found\n");
+    // DER (slot 7) is cheaper to decode and is all newer binaries may carry, XML is the fallback
+    uint32_t der_offset, der_size, xml_offset, xml_size;
+    int has_der = find_entitlements_blob(ctx, CSSLOT_DER_ENTITLEMENTS, CSMAGIC_EMBEDDED_DER_ENTITLEMENTS,
+                                         &der_offset, &der_size) == SUCCESS;
+    macho_error_t err = find_entitlements_blob(ctx, CSSLOT_ENTITLEMENTS, CSMAGIC_EMBEDDED_ENTITLEMENTS,
+                                               &xml_offset, &xml_size);
+    int has_xml = err == SUCCESS;
+    if (!has_der && !has_xml) {
         return err;
     }
     
-    printf("Entitlements found at offset 0x%x, size: %u bytes\n", 
-           entitlements_offset, entitlements_size);
-    
     // Allocate entitlements structure
     *entitlements = calloc(1, sizeof(entitlements_t));
     if (!*entitlements) {
         return ERROR_READ_FAILED;
     }
     
-    // Extract entitlements data (this is a simplified version)
-    // In a full implementation, you would parse the plist data here
-    char* entitlements_data = (char*)ctx->data + entitlements_offset;
+    entitlements_t* result = *entitlements;
+    int parsed = 0;
+    if (has_der) {
+        result->data = (const char*)ctx->data + der_offset;
+        result->offset = der_offset;
+        result->size = der_size;
+        result->format = "der";
+        parsed = plist_parse_der(result->data, result->size, &result->plist) == SUCCESS;
+    }
+    if (!parsed && has_xml) {
+        result->data = (const char*)ctx->data + xml_offset;
+        result->offset = xml_offset;
+        result->size = xml_size;
+        result->format = xml_size >= 8 && memcmp(result->data, "bplist00", 8) == 0 ? "binary" : "xml";
+        parsed = plist_parse(result->data, result->size, &result->plist) == SUCCESS;
+    }
     
-    // For demonstration, we'll just show the raw data exists
-    printf("Entitlements data (first 100 bytes):\n");
-    for (uint32_t i = 0; i < entitlements_size && i < 100; i++) {
-        printf("%c", entitlements_data[i]);
+    // A payload that is not a dictionary is still reported, with a raw preview
+    if (!parsed) {
+        result->error = "Malformed property list";
+        return SUCCESS;
+    }
+    const plist_node_t* root = result->plist.root;
+    if (root->type != PLIST_DICT) {
+        result->error = "Property list root is not a dictionary";
+        return SUCCESS;
+    }
+    if (root->count == 0) {
+        return SUCCESS;
     }
-    printf("\n");
     
-    // Note: Full plist parsing would require libplist or similar
-    // This is a simplified implementation
+    // One array backs the whole list, keys and values stay in the plist arena
+    entitlement_t* entries = calloc(root->count, sizeof(entitlement_t));
+    if (!entries) {
+        free_entitlements(result);
+        *entitlements = NULL;
+        return ERROR_READ_FAILED;
+    }
+    for (uint32_t i = 0; i < root->count; i++) {
+        entries[i].key = root->keys[i];
+        entries[i].value = root->items[i];
+        entries[i].next = i + 1 < root->count ? &entries[i + 1] : NULL;
+    }
+    result->head = entries;
+    result->count = root->count;
     
     return SUCCESS;
 }
 
+// Look up a top level entitlement by key
+const plist_node_t* find_entitlement(const entitlements_t* entitlements, const char* key) {
+    if (!entitlements || entitlements->error || !entitlements->plist.root) return NULL;
+    return plist_dict_get(entitlements->plist.root, key);
+}
+
+// Print one plist value, containers recurse until the depth or node budget runs out
+static void print_plist_value(output_t* out, const char* key, const char* label,
+                              const plist_node_t* node, int depth, uint32_t* budget) {
+    if (*budget == 0) return;
+    (*budget)--;
+    
+    char buffer[64];
+    switch (node->type) {
+        case PLIST_STRING:
+            output_strn(out, key, label, node->string, node->length);
+            break;
+        case PLIST_BOOL:
+            output_bool(out, key, label, node->integer != 0);
+            break;
+        case PLIST_INTEGER:
+            if (node->integer < 0) {
+                snprintf(buffer, sizeof(buffer), "%lld", (long long)node->integer);
+                output_str(out, key, label, buffer);
+            } else {
+                output_uint(out, key, label, (uint64_t)node->integer);
+            }
+            break;
+        case PLIST_REAL:
+            snprintf(buffer, sizeof(buffer), "%g", node->real);
+            output_str(out, key, label, buffer);
+            break;
+        case PLIST_DATE:
+            if (node->string) {
+                output_strn(out, key, label, node->string, node->length);
+            } else {
+                // Binary dates count seconds from 2001-01-01, print them the way XML spells them
+                struct tm tm;
+                time_t seconds = (time_t)(node->real + 978307200.0);
+                if (node->real > -1e11 && node->real < 1e11 && gmtime_r(&seconds, &tm) &&
+                    strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &tm)) {
+                    output_str(out, key, label, buffer);
+                } else {
+                    snprintf(buffer, sizeof(buffer), "%g", node->real);
+                    output_str(out, key, label, buffer);
+                }
+            }
+            break;
+        case PLIST_DATA:
+            snprintf(buffer, sizeof(buffer), "%u bytes", node->length);
+            output_str(out, key, label, buffer);
+            break;
+        case PLIST_ARRAY:
+            if (depth >= OUTPUT_MAX_DEPTH - 4) {
+                output_str(out, key, label, "(nested too deeply)");
+                break;
+            }
+            output_begin_array(out, key, label, node->count);
+            for (uint32_t i = 0; i < node->count && *budget; i++) {
+                print_plist_value(out, NULL, NULL, node->items[i], depth + 1, budget);
+            }
+            output_end_array(out);
+            break;
+        case PLIST_DICT:
+            if (depth >= OUTPUT_MAX_DEPTH - 4) {
+                output_str(out, key, label, "(nested too deeply)");
+                break;
+            }
+            output_begin_object(out, key, label ? label : "Item");
+            for (uint32_t i = 0; i < node->count && *budget; i++) {
+                print_plist_value(out, node->keys[i], node->keys[i], node->items[i], depth + 1, budget);
+            }
+            output_end_object(out);
+            break;
+    }
+}
+
 // Print entitlements information
-void print_entitlements(const entitlements_t* entitlements) {
-    if (!entitlements || !entitlements->head) {
-        printf("No entitlements found\n");
+void print_entitlements(output_t* out, const entitlements_t* entitlements) {
+    output_begin_object(out, "entitlements", "Entitlements");
+    if (!entitlements) {
+        output_str(out, "error", "Error", "No entitlements found");
+        output_end_object(out);
         return;
     }
     
-    printf("Entitlements (%u):\n", entitlements->count);
+    output_hex(out, "offset", "Offset", entitlements->offset);
+    output_uint(out, "size", "Size", entitlements->size);
+    output_str(out, "format", "Format", entitlements->format);
     
-    entitlement_t* current = entitlements->head;
-    while (current) {
-        printf("  %s: %s\n", current->key, current->value);
-        current = current->next;
+    if (entitlements->error) {
+        // Unparsed, show the start of the raw data
+        output_str(out, "error", "Error", entitlements->error);
+        uint32_t preview = entitlements->size < 100 ? entitlements->size : 100;
+        output_strn(out, "data", "Data (first 100 bytes)", entitlements->data, preview);
+    } else {
+        uint32_t budget = ENTITLEMENTS_MAX_PRINTED;
+        output_uint(out, "count", "Count", entitlements->count);
+        output_begin_object(out, "entries", "Entries");
+        for (const entitlement_t* current = entitlements->head; current && budget; current = current->next) {
+            print_plist_value(out, current->key, current->key, current->value, 2, &budget);
+        }
+        output_end_object(out);
+        if (budget == 0) {
+            output_str(out, "truncated", "Truncated", "entry limit reached");
+        }
     }
+    output_end_object(out);
 }
 
 // Free entitlements memory
 void free_entitlements(entitlements_t* entitlements) {
     if (!entitlements) return;
     
-    entitlement_t* current = entitlements->head;
-    while (current) {
-        entitlement_t* next = current->next;
-        if (current->key) free(current->key);
-        if (current->value) free(current->value);
-        free(current);
-        current = next;
-    }
-    
+    // Entries are one allocation, everything else belongs to the plist arena
+    free(entitlements->head);
+    plist_free(&entitlements->plist);
     free(entitlements);
 
 }
-
-
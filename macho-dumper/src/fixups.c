@@ -0,0 +1,463 @@
+/*
+* fixups.c
+* Coded by iosmen (c) 2025
+*/
+#include "../include/macho.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Chained fixups are only produced for little-endian targets, read them as such
+static uint32_t fixup_read32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t fixup_read64(const uint8_t* p) {
+    return (uint64_t)fixup_read32(p) | ((uint64_t)fixup_read32(p + 4) << 32);
+}
+
+static uint16_t fixup_read16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// Fixed part of dyld_chained_starts_in_segment, page_start[] follows
+#define CHAINED_STARTS_SEGMENT_SIZE 22
+
+// Bytes per unit of a pointer's next field
+static uint32_t chained_stride(uint16_t format) {
+    switch (format) {
+        case DYLD_CHAINED_PTR_ARM64E:
+        case DYLD_CHAINED_PTR_ARM64E_USERLAND:
+        case DYLD_CHAINED_PTR_ARM64E_USERLAND24:
+            return 8;
+        case DYLD_CHAINED_PTR_64:
+        case DYLD_CHAINED_PTR_64_OFFSET:
+        case DYLD_CHAINED_PTR_32:
+        case DYLD_CHAINED_PTR_ARM64E_KERNEL:
+        case DYLD_CHAINED_PTR_ARM64E_FIRMWARE:
+        case DYLD_CHAINED_PTR_64_KERNEL_CACHE:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+static int chained_is_32bit(uint16_t format) {
+    return format == DYLD_CHAINED_PTR_32 || format == DYLD_CHAINED_PTR_32_CACHE ||
+           format == DYLD_CHAINED_PTR_32_FIRMWARE;
+}
+
+// Library ordinal stored in bits bits. Like dyld, only the top 15 values are the
+// negative special ordinals (self, main executable, flat, weak), the rest are dylibs.
+static int32_t extend_ordinal(uint32_t ordinal, uint32_t bits) {
+    uint32_t max = (1u << bits) - 1;
+    return ordinal > max - 0xF ? (int32_t)ordinal - (int32_t)(max + 1) : (int32_t)ordinal;
+}
+
+// Validate the payload and every table offset it uses
+macho_error_t parse_chained_fixups(const macho_ctx_t* ctx, chained_fixups_t* fixups) {
+    if (!ctx || !fixups) return ERROR_READ_FAILED;
+    memset(fixups, 0, sizeof(chained_fixups_t));
+    
+    uint32_t dataoff, datasize;
+    if (find_linkedit_data(ctx, LC_DYLD_CHAINED_FIXUPS, &dataoff, &datasize) != SUCCESS || datasize < 28) {
+        return ERROR_INVALID_SECTION;
+    }
+    
+    const uint8_t* data = (const uint8_t*)ctx->data + dataoff;
+    fixups->data = data;
+    fixups->size = datasize;
+    fixups->version = fixup_read32(data);
+    fixups->starts_offset = fixup_read32(data + 4);
+    fixups->imports_offset = fixup_read32(data + 8);
+    fixups->symbols_offset = fixup_read32(data + 12);
+    fixups->imports_count = fixup_read32(data + 16);
+    fixups->imports_format = fixup_read32(data + 20);
+    fixups->symbols_format = fixup_read32(data + 24);
+    
+    uint32_t import_size = fixups->imports_format == DYLD_CHAINED_IMPORT ? 4 :
+                           fixups->imports_format == DYLD_CHAINED_IMPORT_ADDEND ? 8 :
+                           fixups->imports_format == DYLD_CHAINED_IMPORT_ADDEND64 ? 16 : 0;
+    if (fixups->version != 0 || import_size == 0 ||
+        fixups->starts_offset > datasize - 4 ||
+        fixups->imports_offset > datasize ||
+        fixups->imports_count > (datasize - fixups->imports_offset) / import_size ||
+        fixups->symbols_offset > datasize) {
+        return ERROR_INVALID_SECTION;
+    }
+    
+    fixups->seg_count = fixup_read32(data + fixups->starts_offset);
+    if (fixups->seg_count > (datasize - fixups->starts_offset - 4) / 4) {
+        return ERROR_INVALID_SECTION;
+    }
+    
+    // Rebase targets in offset formats are relative to the image base
+    fixups->image_base = get_image_base(ctx);
+    
+    return find_dylib_dependencies(ctx, &fixups->dylibs, &fixups->ndylibs);
+}
+
+void free_chained_fixups(chained_fixups_t* fixups) {
+    if (!fixups) return;
+    
+    for (uint32_t i = 0; i < fixups->ndylibs; i++) {
+        free(fixups->dylibs[i]);
+    }
+    free(fixups->dylibs);
+    memset(fixups, 0, sizeof(chained_fixups_t));
+}
+
+// Offset of a segment's dyld_chained_starts_in_segment, 0 when it has no fixups
+static uint32_t segment_starts_offset(const chained_fixups_t* fixups, uint32_t segment) {
+    if (segment >= fixups->seg_count) return 0;
+    
+    uint32_t offset = fixup_read32(fixups->data + fixups->starts_offset + 4 + segment * 4);
+    if (offset == 0) return 0;
+    
+    uint64_t starts = (uint64_t)fixups->starts_offset + offset;
+    if (starts + CHAINED_STARTS_SEGMENT_SIZE > fixups->size) return 0;
+    return (uint32_t)starts;
+}
+
+int chained_fixups_has_segment(const chained_fixups_t* fixups, uint32_t segment) {
+    return fixups && segment_starts_offset(fixups, segment) != 0;
+}
+
+// Resolve a bind ordinal through the import table
+static void resolve_import(const chained_fixups_t* fixups, uint32_t ordinal, chained_fixup_t* fixup) {
+    fixup->symbol = NULL;
+    fixup->dylib = NULL;
+    if (ordinal >= fixups->imports_count) return;
+    
+    const uint8_t* import = fixups->data + fixups->imports_offset;
+    uint32_t name_offset;
+    if (fixups->imports_format == DYLD_CHAINED_IMPORT_ADDEND64) {
+        uint64_t value = fixup_read64(import + (size_t)ordinal * 16);
+        fixup->lib_ordinal = extend_ordinal((uint32_t)(value & 0xFFFF), 16);
+        fixup->is_weak = (value >> 16) & 1;
+        name_offset = (uint32_t)(value >> 32);
+        fixup->addend += (int64_t)fixup_read64(import + (size_t)ordinal * 16 + 8);
+    } else {
+        uint32_t size = fixups->imports_format == DYLD_CHAINED_IMPORT ? 4 : 8;
+        uint32_t value = fixup_read32(import + (size_t)ordinal * size);
+        fixup->lib_ordinal = extend_ordinal(value & 0xFF, 8);
+        fixup->is_weak = (value >> 8) & 1;
+        name_offset = value >> 9;
+        if (size == 8) {
+            fixup->addend += (int32_t)fixup_read32(import + (size_t)ordinal * 8 + 4);
+        }
+    }
+    
+    // Names must end inside the payload, compressed pools are not decoded
+    uint64_t name = (uint64_t)fixups->symbols_offset + name_offset;
+    if (fixups->symbols_format == 0 && name < fixups->size &&
+        memchr(fixups->data + name, '\0', fixups->size - (size_t)name)) {
+        fixup->symbol = (const char*)fixups->data + name;
+    }
+    
+    fixup->dylib = get_dylib_ordinal_name(fixups->dylibs, fixups->ndylibs, fixup->lib_ordinal);
+}
+
+// Decode one raw pointer, returns the next field (0 ends the chain) or -1 for formats
+// that are not supported
+static int64_t decode_chained_pointer(const chained_fixups_t* fixups, uint16_t format, uint64_t raw,
+                                      chained_fixup_t* fixup) {
+    uint32_t ordinal = 0;
+    uint64_t next;
+    
+    switch (format) {
+        case DYLD_CHAINED_PTR_ARM64E:
+        case DYLD_CHAINED_PTR_ARM64E_USERLAND:
+        case DYLD_CHAINED_PTR_ARM64E_USERLAND24:
+            next = (raw >> 51) & 0x7FF;
+            fixup->is_auth = (raw >> 63) & 1;
+            fixup->is_bind = (raw >> 62) & 1;
+            if (fixup->is_auth) {
+                fixup->diversity = (uint16_t)((raw >> 32) & 0xFFFF);
+                fixup->addr_div = (raw >> 48) & 1;
+                fixup->key = (raw >> 49) & 3;
+            }
+            if (fixup->is_bind) {
+                ordinal = format == DYLD_CHAINED_PTR_ARM64E_USERLAND24 ? (uint32_t)(raw & 0xFFFFFF)
+                                                                         : (uint32_t)(raw & 0xFFFF);
+                if (!fixup->is_auth) {
+                    // 19-bit signed addend
+                    int64_t addend = (int64_t)((raw >> 32) & 0x7FFFF);
+                    if (addend & 0x40000) addend -= 0x80000;
+                    fixup->addend = addend;
+                }
+            } else if (fixup->is_auth) {
+                fixup->target = fixups->image_base + (raw & 0xFFFFFFFF);
+            } else {
+                uint64_t target = raw & 0x7FFFFFFFFFFull;
+                uint64_t high8 = (raw >> 43) & 0xFF;
+                if (format != DYLD_CHAINED_PTR_ARM64E) target += fixups->image_base;
+                fixup->target = target | (high8 << 56);
+            }
+            break;
+            
+        case DYLD_CHAINED_PTR_64:
+        case DYLD_CHAINED_PTR_64_OFFSET:
+            next = (raw >> 51) & 0xFFF;
+            fixup->is_bind = (raw >> 63) & 1;
+            if (fixup->is_bind) {
+                ordinal = (uint32_t)(raw & 0xFFFFFF);
+                fixup->addend = (int64_t)((raw >> 24) & 0xFF);
+            } else {
+                uint64_t target = raw & 0xFFFFFFFFFull;
+                if (format == DYLD_CHAINED_PTR_64_OFFSET) target += fixups->image_base;
+                fixup->target = target | (((raw >> 36) & 0xFF) << 56);
+            }
+            break;
+            
+        case DYLD_CHAINED_PTR_32:
+            next = (raw >> 26) & 0x1F;
+            fixup->is_bind = (raw >> 31) & 1;
+            if (fixup->is_bind) {
+                ordinal = (uint32_t)(raw & 0xFFFFF);
+                fixup->addend = (int64_t)((raw >> 20) & 0x3F);
+            } else {
+                fixup->target = raw & 0x3FFFFFF;
+            }
+            break;
+            
+        default:
+            return -1;
+    }
+    
+    if (fixup->is_bind) {
+        resolve_import(fixups, ordinal, fixup);
+    }
+    return (int64_t)next;
+}
+
+// Follow one chain inside a page: [start, limit) is the page's file range
+static macho_error_t walk_chain(const macho_ctx_t* ctx, const chained_fixups_t* fixups, chained_fixup_t* proto,
+                                uint64_t vmaddr, uint64_t offset, uint64_t limit,
+                                chained_fixup_fn fn, void* arg, uint64_t* count, int* stop) {
+    uint32_t stride = chained_stride(proto->pointer_format);
+    uint32_t width = chained_is_32bit(proto->pointer_format) ? 4 : 8;
+    
+    for (;;) {
+        if (offset + width > limit) return ERROR_INVALID_SECTION;
+        
+        const uint8_t* p = (const uint8_t*)ctx->data + offset;
+        uint64_t raw = width == 4 ? fixup_read32(p) : fixup_read64(p);
+        
+        chained_fixup_t fixup = *proto;
+        fixup.address = vmaddr;
+        int64_t next = decode_chained_pointer(fixups, proto->pointer_format, raw, &fixup);
+        if (next < 0) return ERROR_INVALID_SECTION;
+        
+        (*count)++;
+        if (fn && fn(&fixup, arg)) {
+            *stop = 1;
+            return SUCCESS;
+        }
+        
+        if (next == 0) return SUCCESS;
+        offset += (uint64_t)next * stride;
+        vmaddr += (uint64_t)next * stride;
+    }
+}
+
+// Walk every chain of one segment in address order. Segments are independent, so
+// callers may walk different segments on different threads.
+macho_error_t walk_chained_fixups(const macho_ctx_t* ctx, const chained_fixups_t* fixups, uint32_t segment,
+                                  chained_fixup_fn fn, void* arg, uint64_t* count) {
+    if (!ctx || !fixups || !count) return ERROR_READ_FAILED;
+    *count = 0;
+    
+    uint32_t starts = segment_starts_offset(fixups, segment);
+    if (starts == 0) return SUCCESS;
+    
+    const segment_info_t* segments = NULL;
+    uint32_t nsegments = 0;
+    macho_error_t err = get_segments(ctx, &segments, &nsegments);
+    if (err != SUCCESS) return err;
+    if (segment >= nsegments) return ERROR_INVALID_SEGMENT;
+    
+    const segment_info_t* seg = &segments[segment];
+    const uint8_t* info = fixups->data + starts;
+    uint32_t info_size = fixup_read32(info);
+    uint16_t page_size = fixup_read16(info + 4);
+    uint16_t format = fixup_read16(info + 6);
+    uint16_t page_count = fixup_read16(info + 20);
+    
+    // page_start[] must fit both the declared size and the payload
+    uint64_t max_starts = info_size < CHAINED_STARTS_SEGMENT_SIZE ? 0 :
+                          (info_size - CHAINED_STARTS_SEGMENT_SIZE) / 2;
+    if ((uint64_t)starts + CHAINED_STARTS_SEGMENT_SIZE + max_starts * 2 > fixups->size) {
+        max_starts = (fixups->size - starts - CHAINED_STARTS_SEGMENT_SIZE) / 2;
+    }
+    if (page_count > max_starts || page_size == 0 || chained_stride(format) == 0) {
+        return ERROR_INVALID_SECTION;
+    }
+    
+    uint64_t seg_end = seg->fileoff + seg->filesize;
+    if (seg->fileoff > ctx->size || seg->filesize > ctx->size - seg->fileoff) {
+        return ERROR_INVALID_SEGMENT;
+    }
+    
+    chained_fixup_t proto;
+    memset(&proto, 0, sizeof(proto));
+    proto.segment = segment;
+    proto.pointer_format = format;
+    
+    const uint8_t* page_starts = info + CHAINED_STARTS_SEGMENT_SIZE;
+    int stop = 0;
+    for (uint32_t page = 0; page < page_count && !stop && err == SUCCESS; page++) {
+        uint16_t start = fixup_read16(page_starts + page * 2);
+        if (start == DYLD_CHAINED_PTR_START_NONE) continue;
+        
+        uint64_t page_off = seg->fileoff + (uint64_t)page * page_size;
+        uint64_t page_vm = seg->vmaddr + (uint64_t)page * page_size;
+        uint64_t limit = page_off + page_size < seg_end ? page_off + page_size : seg_end;
+        
+        // 32-bit formats may list several chain starts for a page in overflow entries
+        if (chained_is_32bit(format) && (start & DYLD_CHAINED_PTR_START_MULTI)) {
+            uint32_t index = start & ~DYLD_CHAINED_PTR_START_MULTI;
+            for (; index < max_starts && !stop && err == SUCCESS; index++) {
+                uint16_t entry = fixup_read16(page_starts + index * 2);
+                uint16_t offset = entry & ~DYLD_CHAINED_PTR_START_LAST;
+                err = walk_chain(ctx, fixups, &proto, page_vm + offset, page_off + offset, limit,
+                                 fn, arg, count, &stop);
+                if (entry & DYLD_CHAINED_PTR_START_LAST) break;
+            }
+            continue;
+        }
+        
+        err = walk_chain(ctx, fixups, &proto, page_vm + start, page_off + start, limit,
+                         fn, arg, count, &stop);
+    }
+    
+    return err;
+}
+
+// One segment rendered on a pool worker
+typedef struct {
+    const macho_ctx_t* ctx;
+    const chained_fixups_t* fixups;
+    const segment_info_t* segment;
+    uint32_t index;
+    output_t out;               // Fragment continuing the segment list
+    uint64_t count;
+    macho_error_t err;
+} fixup_segment_job_t;
+
+static const char* const pointer_key_names[] = { "IA", "IB", "DA", "DB" };
+
+static int print_fixup(const chained_fixup_t* fixup, void* arg) {
+    output_t* out = (output_t*)arg;
+    
+    char label[24];
+    snprintf(label, sizeof(label), "0x%llx", (unsigned long long)fixup->address);
+    output_begin_inline(out, "fixup", label);
+    output_hex(out, "address", NULL, fixup->address);
+    output_str(out, "kind", "", fixup->is_bind ? "bind" : "rebase");
+    if (fixup->is_bind) {
+        output_str(out, "symbol", "", fixup->symbol ? fixup->symbol : "?");
+        output_str(out, "dylib", "dylib", fixup->dylib ? fixup->dylib : "?");
+        if (fixup->lib_ordinal > 0) {
+            output_uint(out, "lib_ordinal", NULL, (uint64_t)fixup->lib_ordinal);
+        }
+        if (fixup->addend != 0) {
+            output_hex(out, "addend", "addend", (uint64_t)fixup->addend);
+        }
+        if (fixup->is_weak) {
+            output_bool(out, "weak", "weak", 1);
+        }
+    } else {
+        output_hex(out, "target", "target", fixup->target);
+    }
+    if (fixup->is_auth) {
+        output_str(out, "key", "key", pointer_key_names[fixup->key & 3]);
+        output_hex(out, "diversity", "diversity", fixup->diversity);
+        output_bool(out, "addr_div", "addr_div", fixup->addr_div);
+    }
+    output_end_object(out);
+    return 0;
+}
+
+static void fixup_segment_task(void* arg) {
+    fixup_segment_job_t* job = (fixup_segment_job_t*)arg;
+    output_t* out = &job->out;
+    
+    char segname[17];
+    char label[48];
+    snprintf(segname, sizeof(segname), "%.16s", job->segment->segname);
+    snprintf(label, sizeof(label), "Fixups in %s", segname);
+    output_begin_object(out, "fixup_segment", label);
+    output_str(out, "segname", NULL, segname);
+    
+    output_begin_stream(out, "fixups", NULL, 0);
+    job->err = walk_chained_fixups(job->ctx, job->fixups, job->index, print_fixup, out, &job->count);
+    output_end_array(out);
+    
+    if (job->err != SUCCESS) {
+        output_str(out, "error", "Error", "Malformed fixup chain");
+    }
+    output_uint(out, "count", "Total fixups", job->count);
+    output_end_object(out);
+}
+
+// Print the fixup header and every chain, one pool task per segment with fixups.
+// Segment outputs are appended in load command order.
+macho_error_t print_chained_fixups(output_t* out, const macho_ctx_t* ctx, uint32_t nthreads) {
+    chained_fixups_t fixups;
+    macho_error_t err = parse_chained_fixups(ctx, &fixups);
+    if (err != SUCCESS) {
+        output_str(out, "fixups_error", "Chained Fixups", ctx && ctx->lc_index.chained_fixups ?
+                   "Malformed LC_DYLD_CHAINED_FIXUPS" : "None");
+        free_chained_fixups(&fixups);
+        return err;
+    }
+    
+    output_begin_object(out, "chained_fixups", "Chained Fixups");
+    output_uint(out, "version", "Version", fixups.version);
+    output_uint(out, "imports_count", "Imports", fixups.imports_count);
+    output_uint(out, "imports_format", "Imports format", fixups.imports_format);
+    output_uint(out, "symbols_format", "Symbols format", fixups.symbols_format);
+    output_end_object(out);
+    
+    const segment_info_t* segments = NULL;
+    uint32_t nsegments = 0;
+    get_segments(ctx, &segments, &nsegments);
+    
+    uint32_t njobs = 0;
+    fixup_segment_job_t* jobs = calloc(nsegments ? nsegments : 1, sizeof(fixup_segment_job_t));
+    if (!jobs) {
+        free_chained_fixups(&fixups);
+        return ERROR_READ_FAILED;
+    }
+    
+    output_begin_array(out, "fixup_segments", NULL, 0);
+    thread_pool_t* pool = thread_pool_create(nthreads, 0);
+    for (uint32_t i = 0; i < nsegments; i++) {
+        if (!chained_fixups_has_segment(&fixups, i)) continue;
+        
+        fixup_segment_job_t* job = &jobs[njobs];
+        job->ctx = ctx;
+        job->fixups = &fixups;
+        job->segment = &segments[i];
+        job->index = i;
+        output_init_fragment(&job->out, out, njobs > 0);
+        if (!pool || thread_pool_submit(pool, fixup_segment_task, job) != SUCCESS) {
+            fixup_segment_task(job);
+        }
+        njobs++;
+    }
+    thread_pool_wait(pool);
+    thread_pool_destroy(pool);
+    
+    for (uint32_t i = 0; i < njobs; i++) {
+        output_append(out, &jobs[i].out);
+        output_free(&jobs[i].out);
+        if (jobs[i].err != SUCCESS) err = jobs[i].err;
+    }
+    output_end_array(out);
+    
+    free(jobs);
+    free_chained_fixups(&fixups);
+    return err;
+
+}
@@ -9,26 +9,110 @@
 #include <string.h>
 #include <stdlib.h>
 
-// Parse load commands from Mach-O file
+// File a command into its lookup bucket, commands too small for their type are skipped.
+// Dylibs are the exception, a bind ordinal counts every dylib command.
+static void index_load_command(load_command_index_t* index, const load_command_t* entry, uint32_t i) {
+    switch (entry->cmd) {
+        case LC_SEGMENT:
+            if (entry->cmdsize >= sizeof(struct segment_command)) index->segments[index->nsegments++] = i;
+            break;
+        case LC_SEGMENT_64:
+            if (entry->cmdsize >= sizeof(struct segment_command_64)) index->segments[index->nsegments++] = i;
+            break;
+        case LC_LOAD_DYLIB:
+        case LC_LOAD_WEAK_DYLIB:
+        case LC_REEXPORT_DYLIB:
+        case LC_LAZY_LOAD_DYLIB:
+        case LC_LOAD_UPWARD_DYLIB:
+            index->dylibs[index->ndylibs++] = i;
+            break;
+        case LC_RPATH:
+            if (entry->cmdsize >= sizeof(struct rpath_command)) index->rpaths[index->nrpaths++] = i;
+            break;
+        case LC_SYMTAB:
+            if (entry->cmdsize >= sizeof(struct symtab_command)) index->symtab = entry;
+            break;
+        case LC_DYSYMTAB:
+            if (entry->cmdsize >= sizeof(struct dysymtab_command)) index->dysymtab = entry;
+            break;
+        case LC_DYLD_INFO:
+        case LC_DYLD_INFO_ONLY:
+            if (entry->cmdsize >= sizeof(struct dyld_info_command)) index->dyld_info = entry;
+            break;
+        case LC_BUILD_VERSION:
+            if (entry->cmdsize >= sizeof(struct build_version_command)) index->build_version = entry;
+            break;
+        case LC_ID_DYLIB:
+            if (entry->cmdsize >= sizeof(struct dylib_command)) index->id_dylib = entry;
+            break;
+        case LC_MAIN:
+            if (entry->cmdsize >= sizeof(struct entry_point_command)) index->entry_point = entry;
+            break;
+        case LC_UUID:
+            if (entry->cmdsize >= sizeof(struct uuid_command)) index->uuid = entry;
+            break;
+        case LC_CODE_SIGNATURE:
+        case LC_SEGMENT_SPLIT_INFO:
+        case LC_FUNCTION_STARTS:
+        case LC_DATA_IN_CODE:
+        case LC_DYLIB_CODE_SIGN_DRS:
+        case LC_LINKER_OPTIMIZATION_HINT:
+        case LC_DYLD_EXPORTS_TRIE:
+        case LC_DYLD_CHAINED_FIXUPS:
+            if (entry->cmdsize < sizeof(struct linkedit_data_command)) break;
+            index->linkedit[index->nlinkedit++] = i;
+            if (entry->cmd == LC_CODE_SIGNATURE) index->code_signature = entry;
+            if (entry->cmd == LC_FUNCTION_STARTS) index->function_starts = entry;
+            if (entry->cmd == LC_DYLD_EXPORTS_TRIE) index->exports_trie = entry;
+            if (entry->cmd == LC_DYLD_CHAINED_FIXUPS) index->chained_fixups = entry;
+            break;
+        default:
+            break;
+    }
+}
+
+// Parse load commands from Mach-O file into a flat table of views,
+// indexing them by type in the same pass
 macho_error_t parse_load_commands(macho_ctx_t* ctx) {
     if (!ctx || !ctx->data) return ERROR_READ_FAILED;
     
-    // Allocate array for load commands
-    ctx->load_commands = calloc(ctx->ncmds, sizeof(struct load_command*));
-    if (!ctx->load_commands) return ERROR_READ_FAILED;
+    ctx->load_commands = NULL;
+    ctx->nload_commands = 0;
+    memset(&ctx->lc_index, 0, sizeof(load_command_index_t));
     
     // Calculate load commands offset
     uintptr_t offset = ctx->is_64bit ? sizeof(struct mach_header_64) : sizeof(struct mach_header);
     uintptr_t end_offset = offset + ctx->sizeofcmds;
     
     if (end_offset > ctx->size) {
-        free(ctx->load_commands);
         return ERROR_INVALID_SEGMENT;
     }
     
+    // Every command is at least 8 bytes, don't trust ncmds beyond that
+    if (ctx->ncmds > ctx->sizeofcmds / sizeof(struct load_command)) {
+        return ERROR_INVALID_SEGMENT;
+    }
+    
+    // Allocate the whole table once
+    uint32_t table_size = ctx->ncmds ? ctx->ncmds : 1;
+    ctx->load_commands = calloc(table_size, sizeof(load_command_t));
+    if (!ctx->load_commands) return ERROR_READ_FAILED;
+    
+    // Bucket storage: each command lands in at most one bucket, so ncmds slots each
+    uint32_t* buckets = calloc((size_t)table_size * 4, sizeof(uint32_t));
+    if (!buckets) {
+        free(ctx->load_commands);
+        ctx->load_commands = NULL;
+        return ERROR_READ_FAILED;
+    }
+    ctx->lc_index.segments = buckets;
+    ctx->lc_index.dylibs = buckets + table_size;
+    ctx->lc_index.rpaths = buckets + table_size * 2;
+    ctx->lc_index.linkedit = buckets + table_size * 3;
+    
     // Parse each load command
     for (uint32_t i = 0; i < ctx->ncmds; i++) {
-        if (offset + sizeof(struct load_command) > ctx->size) {
+        if (offset + sizeof(struct load_command) > end_offset) {
             break;
         }
         
@@ -36,21 +120,17 @@ macho_error_t parse_load_commands(macho_ctx_t* ctx) {
         uint32_t cmd = ctx->is_swap ? swap32(lc->cmd) : lc->cmd;
         uint32_t cmdsize = ctx->is_swap ? swap32(lc->cmdsize) : lc->cmdsize;
         
-        if (cmdsize < sizeof(struct load_command) || offset + cmdsize > ctx->size) {
+        if (cmdsize < sizeof(struct load_command) || offset + cmdsize > end_offset) {
             break;
         }
         
-        // Copy load command data
-        ctx->load_commands[i] = malloc(cmdsize);
-        if (!ctx->load_commands[i]) {
-            // Cleanup on failure
-            for (uint32_t j = 0; j < i; j++) {
-                free(ctx->load_commands[j]);
-            }
-            free(ctx->load_commands);
-            return ERROR_READ_FAILED;
-        }
-        memcpy(ctx->load_commands[i], lc, cmdsize);
+        // Borrow the command in place, no copy
+        load_command_t* entry = &ctx->load_commands[ctx->nload_commands++];
+        entry->cmd = cmd;
+        entry->cmdsize = cmdsize;
+        entry->offset = (uint32_t)offset;
+        entry->data = lc;
+        index_load_command(&ctx->lc_index, entry, ctx->nload_commands - 1);
         
         offset += cmdsize;
     }
@@ -58,17 +138,52 @@ macho_error_t parse_load_commands(macho_ctx_t* ctx) {
     return SUCCESS;
 }
 
+// Free the load command table and its lookup buckets
+void free_load_commands(macho_ctx_t* ctx) {
+    if (!ctx) return;
+    
+    // Commands are views into the image, only the table and buckets are owned
+    free(ctx->load_commands);
+    free(ctx->lc_index.segments);
+    ctx->load_commands = NULL;
+    ctx->nload_commands = 0;
+    memset(&ctx->lc_index, 0, sizeof(load_command_index_t));
+}
+
+// Find a linkedit_data_command by type and return its bounds-checked data range
+macho_error_t find_linkedit_data(const macho_ctx_t* ctx, uint32_t cmd, uint32_t* dataoff, uint32_t* datasize) {
+    if (!ctx || !dataoff || !datasize) return ERROR_READ_FAILED;
+    
+    *dataoff = 0;
+    *datasize = 0;
+    
+    for (uint32_t i = 0; i < ctx->lc_index.nlinkedit; i++) {
+        const load_command_t* lc = &ctx->load_commands[ctx->lc_index.linkedit[i]];
+        if (lc->cmd != cmd) continue;
+        
+        struct linkedit_data_command* data_cmd = (struct linkedit_data_command*)lc->data;
+        uint32_t off = ctx->is_swap ? swap32(data_cmd->dataoff) : data_cmd->dataoff;
+        uint32_t size = ctx->is_swap ? swap32(data_cmd->datasize) : data_cmd->datasize;
+        if ((uint64_t)off + size > ctx->size) {
+            return ERROR_INVALID_SEGMENT;
+        }
+        
+        *dataoff = off;
+        *datasize = size;
+        return SUCCESS;
+    }
+    
+    return ERROR_INVALID_SEGMENT;
+}
+
 // Print load command information
-void print_load_commands(const macho_ctx_t* ctx) {
+void print_load_commands(output_t* out, const macho_ctx_t* ctx) {
     if (!ctx || !ctx->load_commands) return;
     
-    printf("Load Commands:\n");
-    for (uint32_t i = 0; i < ctx->ncmds; i++) {
-        struct load_command* lc = ctx->load_commands[i];
-        if (!lc) continue;
-        
-        uint32_t cmd = ctx->is_swap ? swap32(lc->cmd) : lc->cmd;
-        uint32_t cmdsize = ctx->is_swap ? swap32(lc->cmdsize) : lc->cmdsize;
+    output_begin_array(out, "load_commands", "Load Commands", ctx->nload_commands);
+    for (uint32_t i = 0; i < ctx->nload_commands; i++) {
+        uint32_t cmd = ctx->load_commands[i].cmd;
+        uint32_t cmdsize = ctx->load_commands[i].cmdsize;
         
         const char* cmd_name = "UNKNOWN";
         switch (cmd) {
@@ -79,47 +194,47 @@ void print_load_commands(const macho_ctx_t* ctx) {
             case LC_LOAD_DYLIB: cmd_name = "LC_LOAD_DYLIB"; break;
             case LC_CODE_SIGNATURE: cmd_name = "LC_CODE_SIGNATURE"; break;
             case LC_ENTITLEMENTS: cmd_name = "LC_ENTITLEMENTS"; break;
+            case LC_DYLD_CHAINED_FIXUPS: cmd_name = "LC_DYLD_CHAINED_FIXUPS"; break;
+            case LC_DYLD_EXPORTS_TRIE: cmd_name = "LC_DYLD_EXPORTS_TRIE"; break;
+            case LC_DYLD_INFO: cmd_name = "LC_DYLD_INFO"; break;
+            case LC_DYLD_INFO_ONLY: cmd_name = "LC_DYLD_INFO_ONLY"; break;
         }
         
-        printf("  Command %u: %s (0x%x), Size: %u\n", i, cmd_name, cmd, cmdsize);
+        char label[32];
+        snprintf(label, sizeof(label), "Command %u", i);
+        output_begin_inline(out, "load_command", label);
+        output_str(out, "name", "", cmd_name);
+        output_hex(out, "cmd", "cmd", cmd);
+        output_uint(out, "cmdsize", "size", cmdsize);
+        output_uint(out, "offset", NULL, ctx->load_commands[i].offset);
+        output_end_object(out);
     }
+    output_end_array(out);
 }
 
 // Parse segment commands
-macho_error_t parse_segment_commands(macho_ctx_t* ctx, segment_info_t** segments, uint32_t* nsegments) {
+macho_error_t parse_segment_commands(const macho_ctx_t* ctx, segment_info_t** segments, uint32_t* nsegments) {
     if (!ctx || !segments || !nsegments) return ERROR_READ_FAILED;
     
     *segments = NULL;
     *nsegments = 0;
     
-    // First pass: count segments
-    uint32_t seg_count = 0;
-    for (uint32_t i = 0; i < ctx->ncmds; i++) {
-        struct load_command* lc = ctx->load_commands[i];
-        if (!lc) continue;
-        
-        uint32_t cmd = ctx->is_swap ? swap32(lc->cmd) : lc->cmd;
-        if (cmd == LC_SEGMENT || cmd == LC_SEGMENT_64) {
-            seg_count++;
-        }
-    }
-    
+    // Segment commands come straight from the index
+    uint32_t seg_count = ctx->lc_index.nsegments;
     if (seg_count == 0) return SUCCESS;
     
     // Allocate segments array
     *segments = calloc(seg_count, sizeof(segment_info_t));
     if (!*segments) return ERROR_READ_FAILED;
     
-    // Second pass: parse segments
+    // Parse segments
     uint32_t seg_index = 0;
-    for (uint32_t i = 0; i < ctx->ncmds; i++) {
-        struct load_command* lc = ctx->load_commands[i];
-        if (!lc) continue;
-        
-        uint32_t cmd = ctx->is_swap ? swap32(lc->cmd) : lc->cmd;
+    for (uint32_t i = 0; i < seg_count; i++) {
+        const load_command_t* lc = &ctx->load_commands[ctx->lc_index.segments[i]];
+        uint32_t cmd = lc->cmd;
         
         if (cmd == LC_SEGMENT) {
-            struct segment_command* seg = (struct segment_command*)lc;
+            struct segment_command* seg = (struct segment_command*)lc->data;
             segment_info_t* info = &(*segments)[seg_index];
             
             strncpy(info->segname, seg->segname, 16);
@@ -132,6 +247,12 @@ macho_error_t parse_segment_commands(macho_ctx_t* ctx, segment_info_t** segments
             info->nsects = ctx->is_swap ? swap32(seg->nsects) : seg->nsects;
             info->flags = ctx->is_swap ? swap32(seg->flags) : seg->flags;
             
+            // Sections must lie inside the command
+            if (lc->cmdsize < sizeof(*seg) ||
+                info->nsects > (lc->cmdsize - sizeof(*seg)) / sizeof(struct section)) {
+                info->nsects = 0;
+            }
+            
             // Parse sections if any
             if (info->nsects > 0) {
                 info->sections = calloc(info->nsects, sizeof(section_info_t));
@@ -158,7 +279,7 @@ macho_error_t parse_segment_commands(macho_ctx_t* ctx, segment_info_t** segments
             seg_index++;
         }
         else if (cmd == LC_SEGMENT_64) {
-            struct segment_command_64* seg = (struct segment_command_64*)lc;
+            struct segment_command_64* seg = (struct segment_command_64*)lc->data;
             segment_info_t* info = &(*segments)[seg_index];
             
             strncpy(info->segname, seg->segname, 16);
@@ -171,6 +292,12 @@ macho_error_t parse_segment_commands(macho_ctx_t* ctx, segment_info_t** segments
             info->nsects = ctx->is_swap ? swap32(seg->nsects) : seg->nsects;
             info->flags = ctx->is_swap ? swap32(seg->flags) : seg->flags;
             
+            // Sections must lie inside the command
+            if (lc->cmdsize < sizeof(*seg) ||
+                info->nsects > (lc->cmdsize - sizeof(*seg)) / sizeof(struct section_64)) {
+                info->nsects = 0;
+            }
+            
             // Parse sections if any
             if (info->nsects > 0) {
                 info->sections = calloc(info->nsects, sizeof(section_info_t));
@@ -212,6 +339,128 @@ void free_segments(segment_info_t* segments, uint32_t nsegments) {
         }
     }
     free(segments);
+}
+
+// Hash a segname,sectname pair (names are 16-byte fields, not always terminated)
+static uint32_t hash_section_name(const char* segname, const char* sectname) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < 16 && segname[i]; i++) {
+        hash = (hash ^ (uint8_t)segname[i]) * 16777619u;
+    }
+    hash = (hash ^ ',') * 16777619u;
+    for (size_t i = 0; i < 16 && sectname[i]; i++) {
+        hash = (hash ^ (uint8_t)sectname[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Build the section hash table over the cached segment model
+static macho_error_t build_section_table(macho_cache_t* cache) {
+    uint32_t nsections = 0;
+    for (uint32_t i = 0; i < cache->nsegments; i++) {
+        nsections += cache->segments[i].nsects;
+    }
+    
+    // Keep the load factor at or below one half
+    uint32_t table_size = 8;
+    while (table_size < nsections * 2) {
+        table_size <<= 1;
+    }
+    
+    cache->section_table = calloc(table_size, sizeof(section_info_t*));
+    if (!cache->section_table) return ERROR_READ_FAILED;
+    cache->section_table_size = table_size;
+    
+    for (uint32_t i = 0; i < cache->nsegments; i++) {
+        for (uint32_t j = 0; j < cache->segments[i].nsects; j++) {
+            const section_info_t* sect = &cache->segments[i].sections[j];
+            uint32_t slot = hash_section_name(sect->segname, sect->sectname) & (table_size - 1);
+            
+            // First definition wins, like the linear search it replaces
+            while (cache->section_table[slot]) {
+                const section_info_t* other = cache->section_table[slot];
+                if (strncmp(other->segname, sect->segname, 16) == 0 &&
+                    strncmp(other->sectname, sect->sectname, 16) == 0) {
+                    break;
+                }
+                slot = (slot + 1) & (table_size - 1);
+            }
+            if (!cache->section_table[slot]) {
+                cache->section_table[slot] = sect;
+            }
+        }
+    }
+    
+    return SUCCESS;
+}
+
+// Get the segment model owned by the context, building it on first use
+macho_error_t get_segments(const macho_ctx_t* ctx, const segment_info_t** segments, uint32_t* nsegments) {
+    if (!ctx || !ctx->cache || !segments || !nsegments) return ERROR_READ_FAILED;
+    
+    macho_cache_t* cache = ctx->cache;
+    pthread_mutex_lock(&cache->lock);
+    if (!cache->segments_built) {
+        cache->segments_err = parse_segment_commands(ctx, &cache->segments, &cache->nsegments);
+        if (cache->segments_err == SUCCESS) {
+            cache->segments_err = build_section_table(cache);
+        }
+        cache->segments_built = 1;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    
+    *segments = cache->segments;
+    *nsegments = cache->nsegments;
+    return cache->segments_err;
+}
+
+// Find a segment by name in the cached model
+const segment_info_t* find_segment(const macho_ctx_t* ctx, const char* segname) {
+    const segment_info_t* segments = NULL;
+    uint32_t nsegments = 0;
+    if (!segname || get_segments(ctx, &segments, &nsegments) != SUCCESS) return NULL;
+    
+    for (uint32_t i = 0; i < nsegments; i++) {
+        if (strncmp(segments[i].segname, segname, 16) == 0) {
+            return &segments[i];
+        }
+    }
+    return NULL;
+}
+
+// Address the image is linked at: vmaddr of the segment mapping the header (file offset 0).
+// Export trie addresses and offset-style fixups are relative to it.
+uint64_t get_image_base(const macho_ctx_t* ctx) {
+    const segment_info_t* segments = NULL;
+    uint32_t nsegments = 0;
+    if (get_segments(ctx, &segments, &nsegments) != SUCCESS) return 0;
+    
+    for (uint32_t i = 0; i < nsegments; i++) {
+        if (segments[i].fileoff == 0 && segments[i].filesize != 0) {
+            return segments[i].vmaddr;
+        }
+    }
+    return 0;
+}
+
+// Find a section by segname,sectname through the hash table
+const section_info_t* find_section(const macho_ctx_t* ctx, const char* segname, const char* sectname) {
+    const segment_info_t* segments = NULL;
+    uint32_t nsegments = 0;
+    if (!segname || !sectname || get_segments(ctx, &segments, &nsegments) != SUCCESS) return NULL;
+    
+    const macho_cache_t* cache = ctx->cache;
+    uint32_t mask = cache->section_table_size - 1;
+    uint32_t slot = hash_section_name(segname, sectname) & mask;
+    
+    while (cache->section_table[slot]) {
+        const section_info_t* sect = cache->section_table[slot];
+        if (strncmp(sect->segname, segname, 16) == 0 && strncmp(sect->sectname, sectname, 16) == 0) {
+            return sect;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return NULL;
 
 }
 
@@ -7,60 +7,236 @@
 #include <string.h>
 #include <stdlib.h>
 
-// Parse Mach-O or FAT binary
-macho_error_t parse_macho(macho_ctx_t* ctx, const char* filename) {
-    if (!ctx || !filename) return ERROR_READ_FAILED;
+// Read a big-endian FAT header field
+static uint32_t fat32(uint32_t magic, uint32_t value) {
+    return (magic == FAT_CIGAM || magic == FAT_CIGAM_64) ? swap32(value) : value;
+}
+
+static uint64_t fat64(uint32_t magic, uint64_t value) {
+    return (magic == FAT_CIGAM || magic == FAT_CIGAM_64) ? swap64(value) : value;
+}
+
+// Index every architecture slice of a FAT image
+static macho_error_t index_fat_archs(macho_file_t* file, uint32_t magic) {
+    struct fat_header* fat_header = (struct fat_header*)file->data;
+    uint32_t nfat_arch = fat32(magic, fat_header->nfat_arch);
+    int is_64 = (magic == FAT_MAGIC_64 || magic == FAT_CIGAM_64);
+    size_t arch_size = is_64 ? sizeof(struct fat_arch_64) : sizeof(struct fat_arch);
     
-    memset(ctx, 0, sizeof(macho_ctx_t));
+    if (nfat_arch == 0 || nfat_arch > (file->size - sizeof(struct fat_header)) / arch_size) {
+        return ERROR_INVALID_MAGIC;
+    }
+    
+    file->archs = calloc(nfat_arch, sizeof(macho_arch_t));
+    if (!file->archs) return ERROR_READ_FAILED;
+    
+    for (uint32_t i = 0; i < nfat_arch; i++) {
+        macho_arch_t* info = &file->archs[i];
+        
+        // The image may be mapped read-only, so swap into the index
+        if (is_64) {
+            struct fat_arch_64* arch = (struct fat_arch_64*)(fat_header + 1) + i;
+            info->cputype = fat32(magic, arch->cputype);
+            info->cpusubtype = fat32(magic, arch->cpusubtype);
+            info->offset = fat64(magic, arch->offset);
+            info->size = fat64(magic, arch->size);
+            info->align = fat32(magic, arch->align);
+        } else {
+            struct fat_arch* arch = (struct fat_arch*)(fat_header + 1) + i;
+            info->cputype = fat32(magic, arch->cputype);
+            info->cpusubtype = fat32(magic, arch->cpusubtype);
+            info->offset = fat32(magic, arch->offset);
+            info->size = fat32(magic, arch->size);
+            info->align = fat32(magic, arch->align);
+        }
+        
+        if (info->offset > file->size || info->size > file->size - info->offset ||
+            info->size < sizeof(struct mach_header)) {
+            free(file->archs);
+            file->archs = NULL;
+            return ERROR_INVALID_MAGIC;
+        }
+    }
+    
+    file->narchs = nfat_arch;
+    return SUCCESS;
+}
+
+// Open a Mach-O or FAT file and index its architecture slices
+macho_error_t open_macho_file(macho_file_t* file, const char* filename) {
+    if (!file || !filename) return ERROR_READ_FAILED;
+    
+    memset(file, 0, sizeof(macho_file_t));
+    
+    // Map file into memory, fall back to reading it for non-mappable inputs
+    file->data = map_file(filename, &file->size);
+    if (file->data) {
+        file->is_mapped = 1;
+    } else {
+        file->data = read_file(filename, &file->size);
+    }
+    if (!file->data) return ERROR_FILE_NOT_FOUND;
     
-    // Read file into memory
-    ctx->data = read_file(filename, &ctx->size);
-    if (!ctx->data) return ERROR_FILE_NOT_FOUND;
+    if (file->size < sizeof(struct mach_header)) {
+        close_macho_file(file);
+        return ERROR_INVALID_MAGIC;
+    }
     
     // Check magic number
-    uint32_t magic = *(uint32_t*)ctx->data;
+    uint32_t magic = *(uint32_t*)file->data;
     if (!validate_magic(magic)) {
-        free_file(ctx->data);
+        close_macho_file(file);
         return ERROR_INVALID_MAGIC;
     }
     
-    // Handle FAT binaries
-    if (magic == FAT_MAGIC || magic == FAT_CIGAM) {
-        ctx->is_fat = 1;
-        // For simplicity, we'll use the first architecture in FAT binary
-        struct fat_header* fat_header = (struct fat_header*)ctx->data;
-        struct fat_arch* arch = (struct fat_arch*)(fat_header + 1);
-        
-        if (magic == FAT_CIGAM) {
-            arch->offset = swap32(arch->offset);
-            arch->size = swap32(arch->size);
-            arch->cputype = swap32(arch->cputype);
+    macho_error_t err = SUCCESS;
+    if (magic == FAT_MAGIC || magic == FAT_CIGAM || magic == FAT_MAGIC_64 || magic == FAT_CIGAM_64) {
+        file->is_fat = 1;
+        err = index_fat_archs(file, magic);
+    } else {
+        // Thin binaries are a single slice at offset 0
+        file->archs = calloc(1, sizeof(macho_arch_t));
+        if (!file->archs) {
+            err = ERROR_READ_FAILED;
+        } else {
+            struct mach_header* header = (struct mach_header*)file->data;
+            int swap = (magic == MH_CIGAM || magic == MH_CIGAM_64);
+            file->archs[0].cputype = swap ? (cpu_type_t)swap32(header->cputype) : header->cputype;
+            file->archs[0].cpusubtype = swap ? (cpu_subtype_t)swap32(header->cpusubtype) : header->cpusubtype;
+            file->archs[0].size = file->size;
+            file->narchs = 1;
         }
-        
-        // Use the first architecture
-        void* macho_data = (char*)ctx->data + arch->offset;
-        size_t macho_size = arch->size;
-        
-        // Create a new context for the thin binary
-        void* thin_data = malloc(macho_size);
-        if (!thin_data) {
-            free_file(ctx->data);
-            return ERROR_READ_FAILED;
+    }
+    
+    if (err != SUCCESS) {
+        close_macho_file(file);
+    }
+    return err;
+}
+
+// Release the file image and architecture index
+void close_macho_file(macho_file_t* file) {
+    if (!file) return;
+    
+    if (file->data) {
+        if (file->is_mapped) {
+            unmap_file(file->data, file->size);
+        } else {
+            free_file(file->data);
         }
-        memcpy(thin_data, macho_data, macho_size);
-        
-        free_file(ctx->data);
-        ctx->data = thin_data;
-        ctx->size = macho_size;
-        ctx->is_fat = 0;
-        
-        // Re-check magic for the thin binary
-        magic = *(uint32_t*)ctx->data;
+    }
+    free(file->archs);
+    memset(file, 0, sizeof(macho_file_t));
+}
+
+// Get architecture name as used by lipo/-arch
+const char* get_arch_name(cpu_type_t cputype, cpu_subtype_t cpusubtype) {
+    cpu_subtype_t subtype = cpusubtype & ~CPU_SUBTYPE_MASK;
+    
+    switch (cputype) {
+        case CPU_TYPE_ARM64:
+            return subtype == CPU_SUBTYPE_ARM64E ? "arm64e" : "arm64";
+        case CPU_TYPE_ARM64_32: return "arm64_32";
+        case CPU_TYPE_X86_64:
+            return subtype == CPU_SUBTYPE_X86_64_H ? "x86_64h" : "x86_64";
+        case CPU_TYPE_X86: return "i386";
+        case CPU_TYPE_ARM:
+            switch (subtype) {
+                case CPU_SUBTYPE_ARM_V7: return "armv7";
+                case CPU_SUBTYPE_ARM_V7S: return "armv7s";
+                case CPU_SUBTYPE_ARM_V7K: return "armv7k";
+                default: return "arm";
+            }
+        case CPU_TYPE_POWERPC: return "ppc";
+        case CPU_TYPE_POWERPC64: return "ppc64";
+        default: return "unknown";
+    }
+}
+
+// Find the slice matching an architecture name, -1 if absent
+int find_macho_arch(const macho_file_t* file, const char* name) {
+    if (!file || !name) return -1;
+    
+    for (uint32_t i = 0; i < file->narchs; i++) {
+        if (strcmp(get_arch_name(file->archs[i].cputype, file->archs[i].cpusubtype), name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+// Hint the pager: __LINKEDIT is accessed randomly (symbols, strings, signature)
+static void advise_linkedit(const macho_ctx_t* ctx) {
+    for (uint32_t i = 0; i < ctx->lc_index.nsegments; i++) {
+        const load_command_t* lc = &ctx->load_commands[ctx->lc_index.segments[i]];
+        if (lc->cmd == LC_SEGMENT_64) {
+            struct segment_command_64* seg = (struct segment_command_64*)lc->data;
+            if (strncmp(seg->segname, "__LINKEDIT", 16) == 0) {
+                uint64_t fileoff = ctx->is_swap ? swap64(seg->fileoff) : seg->fileoff;
+                uint64_t filesize = ctx->is_swap ? swap64(seg->filesize) : seg->filesize;
+                advise_file_range(ctx->data, ctx->size, fileoff, filesize, ADVISE_RANDOM);
+            }
+        } else if (lc->cmd == LC_SEGMENT) {
+            struct segment_command* seg = (struct segment_command*)lc->data;
+            if (strncmp(seg->segname, "__LINKEDIT", 16) == 0) {
+                uint32_t fileoff = ctx->is_swap ? swap32(seg->fileoff) : seg->fileoff;
+                uint32_t filesize = ctx->is_swap ? swap32(seg->filesize) : seg->filesize;
+                advise_file_range(ctx->data, ctx->size, fileoff, filesize, ADVISE_RANDOM);
+            }
+        }
+    }
+}
+
+// Parse Mach-O or FAT binary, using the first architecture of a FAT file
+macho_error_t parse_macho(macho_ctx_t* ctx, const char* filename) {
+    if (!ctx || !filename) return ERROR_READ_FAILED;
+    
+    memset(ctx, 0, sizeof(macho_ctx_t));
+    
+    macho_file_t* file = calloc(1, sizeof(macho_file_t));
+    if (!file) return ERROR_READ_FAILED;
+    
+    macho_error_t err = open_macho_file(file, filename);
+    if (err != SUCCESS) {
+        free(file);
+        return err;
+    }
+    
+    err = parse_macho_slice(ctx, file, 0);
+    ctx->owned_file = file;
+    return err;
+}
+
+// Parse one architecture slice, the slice is a view into the file image
+macho_error_t parse_macho_slice(macho_ctx_t* ctx, const macho_file_t* file, uint32_t index) {
+    if (!ctx || !file || index >= file->narchs) return ERROR_READ_FAILED;
+    
+    memset(ctx, 0, sizeof(macho_ctx_t));
+    
+    const macho_arch_t* arch = &file->archs[index];
+    ctx->cache = calloc(1, sizeof(macho_cache_t));
+    if (!ctx->cache) return ERROR_READ_FAILED;
+    pthread_mutex_init(&ctx->cache->lock, NULL);
+    
+    ctx->file = file;
+    ctx->arch_index = index;
+    ctx->is_fat = file->is_fat;
+    ctx->base_offset = arch->offset;
+    ctx->data = (char*)file->data + arch->offset;
+    ctx->size = arch->size;
+    
+    // Check magic for the thin binary
+    uint32_t magic = *(uint32_t*)ctx->data;
+    if (magic != MH_MAGIC && magic != MH_CIGAM && magic != MH_MAGIC_64 && magic != MH_CIGAM_64) {
+        return ERROR_INVALID_MAGIC;
     }
     
     // Determine architecture and endianness
     ctx->is_64bit = (magic == MH_MAGIC_64 || magic == MH_CIGAM_64);
     ctx->is_swap = (magic == MH_CIGAM || magic == MH_CIGAM_64);
+    if (ctx->is_64bit && ctx->size < sizeof(struct mach_header_64)) {
+        return ERROR_INVALID_MAGIC;
+    }
     
     // Parse Mach-O header
     if (ctx->is_64bit) {
@@ -81,41 +257,64 @@ macho_error_t parse_macho(macho_ctx_t* ctx, const char* filename) {
         ctx->flags = ctx->is_swap ? swap32(header->flags) : header->flags;
     }
     
+    // Header and load commands are read right away
+    if (file->is_mapped) {
+        size_t header_size = ctx->is_64bit ? sizeof(struct mach_header_64) : sizeof(struct mach_header);
+        advise_file_range(ctx->data, ctx->size, 0, header_size + ctx->sizeofcmds, ADVISE_WILLNEED);
+    }
+    
     // Parse load commands
-    return parse_load_commands(ctx);
+    macho_error_t err = parse_load_commands(ctx);
+    if (err == SUCCESS && file->is_mapped) {
+        advise_linkedit(ctx);
+    }
+    return err;
 }
 
 // Print Mach-O header information
-void print_header_info(const macho_ctx_t* ctx) {
+void print_header_info(output_t* out, const macho_ctx_t* ctx) {
     if (!ctx) return;
     
-    printf("Mach-O Header Information:\n");
-    printf("  Architecture: %s\n", ctx->is_64bit ? "64-bit" : "32-bit");
-    printf("  CPU Type: 0x%x\n", ctx->cputype);
-    printf("  CPU Subtype: 0x%x\n", ctx->cpusubtype);
-    printf("  File Type: 0x%x\n", ctx->filetype);
-    printf("  Number of Load Commands: %u\n", ctx->ncmds);
-    printf("  Size of Load Commands: %u\n", ctx->sizeofcmds);
-    printf("  Flags: 0x%x\n", ctx->flags);
-    printf("  FAT Binary: %s\n", ctx->is_fat ? "Yes" : "No");
-    printf("  Byte Swap: %s\n", ctx->is_swap ? "Yes" : "No");
+    output_begin_object(out, "header", "Mach-O Header Information");
+    output_str(out, "architecture", "Architecture", ctx->is_64bit ? "64-bit" : "32-bit");
+    output_hex(out, "cputype", "CPU Type", (uint32_t)ctx->cputype);
+    output_hex(out, "cpusubtype", "CPU Subtype", (uint32_t)ctx->cpusubtype);
+    output_hex(out, "filetype", "File Type", ctx->filetype);
+    output_str(out, "filetype_name", NULL, get_file_type_name(ctx->filetype));
+    output_uint(out, "ncmds", "Number of Load Commands", ctx->ncmds);
+    output_uint(out, "sizeofcmds", "Size of Load Commands", ctx->sizeofcmds);
+    output_hex(out, "flags", "Flags", ctx->flags);
+    output_bool(out, "is_fat", "FAT Binary", ctx->is_fat);
+    if (ctx->is_fat) {
+        output_begin_inline(out, "slice", "Slice");
+        output_str(out, "arch", "arch", get_arch_name(ctx->cputype, ctx->cpusubtype));
+        output_hex(out, "offset", "offset", ctx->base_offset);
+        output_uint(out, "size", "size", ctx->size);
+        output_end_object(out);
+    }
+    output_bool(out, "is_swap", "Byte Swap", ctx->is_swap);
+    output_end_object(out);
 }
 
 // Free Mach-O context
 void free_macho_context(macho_ctx_t* ctx) {
     if (!ctx) return;
     
-    if (ctx->data) {
-        free_file(ctx->data);
+    free_load_commands(ctx);
+    
+    if (ctx->cache) {
+        free_segments(ctx->cache->segments, ctx->cache->nsegments);
+        free(ctx->cache->section_table);
+        free_symbol_index(&ctx->cache->symbols);
+        free_code_signature(&ctx->cache->signature);
+        pthread_mutex_destroy(&ctx->cache->lock);
+        free(ctx->cache);
+        ctx->cache = NULL;
     }
     
-    if (ctx->load_commands) {
-        for (uint32_t i = 0; i < ctx->ncmds; i++) {
-            if (ctx->load_commands[i]) {
-                free(ctx->load_commands[i]);
-            }
-        }
-        free(ctx->load_commands);
+    if (ctx->owned_file) {
+        close_macho_file(ctx->owned_file);
+        free(ctx->owned_file);
     }
 
 }
@@ -6,6 +6,55 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+
+// Names collected from repeatable options, owned
+typedef struct {
+    char** items;
+    uint32_t count;
+    uint32_t cap;
+} name_list_t;
+
+// Selected report sections
+typedef struct {
+    int show_all;
+    int show_load_cmds;
+    int show_segments;
+    int show_deps;
+    int show_dep_tree;
+    dep_graph_format_t dep_graph;   // --dep-graph replaces the report with the graph alone
+    dependency_options_t deps;
+    int show_codesign;
+    int show_verify;
+    int show_entitlements;
+    int show_disasm;
+    int show_fixups;
+    int show_dyld_info;
+    disasm_options_t disasm;
+    uint64_t* addresses;            // --address, owned
+    uint32_t naddresses;
+    uint32_t addresses_cap;
+    name_list_t symbols;            // --symbol and --symbol-list
+    name_list_t exports;            // --export
+    const char* export_prefix;
+    int show_exports;
+    output_format_t format;
+} dump_options_t;
+
+// One slice parsed, and rendered when out is set, on its own thread
+typedef struct {
+    const macho_file_t* file;
+    const char* filename;
+    uint32_t index;
+    const dump_options_t* opts;
+    macho_ctx_t ctx;
+    macho_error_t err;
+    int invalid;                    // --verify found the signature invalid
+    output_t out;
+    int render;
+    pthread_t thread;
+    int started;
+} slice_job_t;
 
 // Print usage information
 void print_usage(const char* program_name) {
@@ -15,9 +64,371 @@ void print_usage(const char* program_name) {
     printf("  -l, --load-cmds     Show load commands\n");
     printf("  -s, --segments      Show segment information\n");
     printf("  -d, --dependencies  Show library dependencies\n");
+    printf("  --dep-tree          Resolve the full dependency closure (@rpath, @loader_path, ...)\n");
+    printf("  --dep-graph <fmt>   Only write the dependency graph: dot, json or edges (loader<TAB>dependency)\n");
+    printf("  --sdk-root <dir>    Look up absolute install names under this root first\n");
+    printf("  --exec-path <f>     Main executable for @executable_path when analyzing a dylib\n");
     printf("  -c, --codesign      Show code signature information\n");
+    printf("  --verify            Re-hash the signed pages and blobs against every CodeDirectory\n");
     printf("  -e, --entitlements  Show entitlements\n");
     printf("  -a, --all           Show all information\n");
+    printf("  --arch <name>       Analyze the given architecture of a FAT binary (e.g. arm64e)\n");
+    printf("  --all-archs         Analyze every architecture of a FAT binary\n");
+    printf("  -dis, --disassemble Disassemble code sections (arm64, arm64_32, x86_64, i386, arm)\n");
+    printf("  --start-address <a> Only disassemble from this address\n");
+    printf("  --stop-address <a>  Stop disassembling at this address\n");
+    printf("  --dis-symbol <name> Only disassemble this symbol, up to the next one\n");
+    printf("  --skip-data         Disassemble past embedded data instead of stopping\n");
+    printf("  --address <a>       Symbolicate an address as symbol+offset (repeatable)\n");
+    printf("  --symbol <name>     Look up a symbol's address, section and flags (repeatable)\n");
+    printf("  --symbol-list <f>   Look up every name listed in a file, one per line ('-' is stdin)\n");
+    printf("  --fixups            Decode LC_DYLD_CHAINED_FIXUPS rebase and bind chains\n");
+    printf("  --dyld-info         Decode LC_DYLD_INFO rebase/bind/weak/lazy opcodes and exports\n");
+    printf("  --exports           List every exported symbol sorted by name\n");
+    printf("  --export <name>     Look up one export in the trie (repeatable)\n");
+    printf("  --export-prefix <p> List the exports starting with a prefix\n");
+    printf("  --jobs <n>          Worker threads for disassembly, fixups, --verify and --dep-tree (default: one per CPU)\n");
+    printf("  --format <fmt>      Output format: text (default), json or ndjson\n");
+    printf("  --ndjson            Stream one JSON record per line as results are produced\n");
+    printf("                      (section: -s listing, disasm_section / insn: disassembly)\n");
+    printf("\nBatch mode: %s --batch [options] <path|->...\n", program_name);
+    printf("  Scans files, directories and .app/.framework bundles, '-' reads paths from stdin\n");
+    printf("  --jobs <n>          Number of worker threads (default: one per CPU)\n");
+    printf("  --manifest <file>   Read paths to scan from a file, one per line\n");
+    printf("  --arch, --all-archs Select architectures as above\n");
+    printf("  --verify            Verify the code signature of every slice\n");
+    printf("  --cdhash            Print the cdhash of every signed slice\n");
+}
+
+// Queue a name from a repeatable option, the array grows as needed
+static int add_name(name_list_t* list, const char* name, size_t len) {
+    if (list->count == list->cap) {
+        uint32_t cap = list->cap ? list->cap * 2 : 16;
+        char** items = realloc(list->items, cap * sizeof(char*));
+        if (!items) return 0;
+        list->items = items;
+        list->cap = cap;
+    }
+    
+    char* copy = malloc(len + 1);
+    if (!copy) return 0;
+    memcpy(copy, name, len);
+    copy[len] = '\0';
+    list->items[list->count++] = copy;
+    return 1;
+}
+
+// Queue an address from a repeated --address, the array grows as needed
+static int add_address(dump_options_t* opts, uint64_t address) {
+    if (opts->naddresses == opts->addresses_cap) {
+        uint32_t cap = opts->addresses_cap ? opts->addresses_cap * 2 : 16;
+        uint64_t* addresses = realloc(opts->addresses, cap * sizeof(uint64_t));
+        if (!addresses) return 0;
+        opts->addresses = addresses;
+        opts->addresses_cap = cap;
+    }
+    
+    opts->addresses[opts->naddresses++] = address;
+    return 1;
+}
+
+// Queue every name listed one per line in a file ("-" is stdin)
+static int read_name_list(name_list_t* list, const char* path) {
+    FILE* file = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!file) return 0;
+    
+    char line[4096];
+    int ok = 1;
+    while (ok && fgets(line, sizeof(line), file)) {
+        size_t len = strcspn(line, "\r\n");
+        if (len > 0) {
+            ok = add_name(list, line, len);
+        }
+    }
+    
+    if (file != stdin) fclose(file);
+    return ok;
+}
+
+static void free_name_list(name_list_t* list) {
+    for (uint32_t i = 0; i < list->count; i++) {
+        free(list->items[i]);
+    }
+    free(list->items);
+    memset(list, 0, sizeof(name_list_t));
+}
+
+static void free_dump_options(dump_options_t* opts) {
+    free_name_list(&opts->symbols);
+    free_name_list(&opts->exports);
+    free(opts->addresses);
+    opts->addresses = NULL;
+    opts->naddresses = 0;
+}
+
+// Write the dependency graph of one slice on its own, for graphviz and diffing tools
+static int export_dependency_graph(const char* filename, const char* arch_name, const dump_options_t* opts) {
+    macho_file_t file;
+    macho_error_t err = open_macho_file(&file, filename);
+    if (err != SUCCESS) {
+        printf("Error: %s\n", macho_strerror(err));
+        return 1;
+    }
+    
+    int index = arch_name ? find_macho_arch(&file, arch_name) : 0;
+    if (index < 0) {
+        printf("Error: Architecture %s not found\n", arch_name);
+        close_macho_file(&file);
+        return 1;
+    }
+    
+    macho_ctx_t ctx;
+    dylib_graph_t graph;
+    err = parse_macho_slice(&ctx, &file, (uint32_t)index);
+    if (err == SUCCESS) {
+        err = build_dependency_tree(&ctx, filename, &opts->deps, &graph);
+    }
+    if (err == SUCCESS) {
+        output_t out;
+        output_init(&out, stdout, opts->dep_graph == DEP_GRAPH_JSON ? OUTPUT_JSON : OUTPUT_TEXT);
+        if (opts->dep_graph == DEP_GRAPH_DOT) {
+            print_dependency_dot(&out, &graph);
+        } else if (opts->dep_graph == DEP_GRAPH_EDGES) {
+            print_dependency_edges(&out, &graph);
+        } else {
+            output_begin_object(&out, NULL, NULL);
+            print_dependency_tree(&out, &graph);
+            output_end_object(&out);
+        }
+        output_free(&out);
+        free_dependency_tree(&graph);
+    } else {
+        printf("Error: %s\n", macho_strerror(err));
+    }
+    
+    free_macho_context(&ctx);
+    close_macho_file(&file);
+    return err == SUCCESS ? 0 : 1;
+}
+
+// Scan many files on a worker pool and print one line per slice
+static int run_batch_mode(int argc, char* argv[]) {
+    batch_options_t opts = {0};
+    const char* manifest = NULL;
+    const char** inputs = calloc((size_t)argc, sizeof(char*));
+    uint32_t ninputs = 0;
+    if (!inputs) return 1;
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            opts.nthreads = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--manifest") == 0 && i + 1 < argc) {
+            manifest = argv[++i];
+        } else if (strcmp(argv[i], "--arch") == 0 && i + 1 < argc) {
+            opts.arch_name = argv[++i];
+        } else if (strcmp(argv[i], "--all-archs") == 0) {
+            opts.all_archs = 1;
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            opts.verify = 1;
+        } else if (strcmp(argv[i], "--cdhash") == 0) {
+            opts.cdhash = 1;
+        } else {
+            inputs[ninputs++] = argv[i];
+        }
+    }
+
+    if (ninputs == 0 && !manifest) {
+        print_usage(argv[0]);
+        free(inputs);
+        return 1;
+    }
+
+    batch_stats_t stats = {0};
+    macho_error_t err = run_batch(inputs, ninputs, manifest, &opts, &stats);
+    free(inputs);
+    if (err != SUCCESS) {
+        printf("Error: %s\n", macho_strerror(err));
+    }
+
+    printf("\nScanned %u files: %u Mach-O, %u slices, %u errors\n",
+           stats.files, stats.machos, stats.slices, stats.errors);
+    if (opts.verify) {
+        printf("Signature verification failed for %u slices\n", stats.invalid);
+    }
+    return (err != SUCCESS || stats.errors > 0 || stats.invalid > 0) ? 1 : 0;
+}
+
+// Print the requested report for one parsed slice, returns 0 when --verify failed
+static int print_slice_report(output_t* out, macho_ctx_t* ctx, const char* filename, const dump_options_t* opts) {
+    // Always show header
+    print_header_info(out, ctx);
+    output_text(out, "\n");
+
+    // Show requested information
+    if (opts->show_all || opts->show_load_cmds) {
+        print_load_commands(out, ctx);
+        output_text(out, "\n");
+    }
+
+    if (opts->show_all || opts->show_segments) {
+        const segment_info_t* segments = NULL;
+        uint32_t nsegments = 0;
+        if (get_segments(ctx, &segments, &nsegments) == SUCCESS) {
+            output_begin_array(out, "segments", "Segments", nsegments);
+            for (uint32_t i = 0; i < nsegments; i++) {
+                char segname[17];
+                snprintf(segname, sizeof(segname), "%.16s", segments[i].segname);
+                output_begin_inline(out, "segment", segname);
+                output_str(out, "segname", NULL, segname);
+                output_hex(out, "vmaddr", "vmaddr", segments[i].vmaddr);
+                output_hex(out, "vmsize", "vmsize", segments[i].vmsize);
+                output_hex(out, "fileoff", "fileoff", segments[i].fileoff);
+                output_hex(out, "filesize", "filesize", segments[i].filesize);
+                output_end_object(out);
+            }
+            output_end_array(out);
+            output_text(out, "\n");
+
+            uint32_t nsections = 0;
+            for (uint32_t i = 0; i < nsegments; i++) {
+                nsections += segments[i].nsects;
+            }
+            output_begin_array(out, "sections", "Sections", nsections);
+            for (uint32_t i = 0; i < nsegments; i++) {
+                for (uint32_t j = 0; j < segments[i].nsects; j++) {
+                    const section_info_t* sect = &segments[i].sections[j];
+                    char label[40];
+                    snprintf(label, sizeof(label), "%.16s,%.16s", sect->segname, sect->sectname);
+                    output_begin_inline(out, "section", label);
+                    output_strn(out, "segname", NULL, sect->segname, strnlen(sect->segname, 16));
+                    output_strn(out, "sectname", NULL, sect->sectname, strnlen(sect->sectname, 16));
+                    output_hex(out, "addr", "addr", sect->addr);
+                    output_hex(out, "size", "size", sect->size);
+                    output_hex(out, "offset", "offset", sect->offset);
+                    output_hex(out, "flags", "flags", sect->flags);
+                    output_end_object(out);
+                }
+            }
+            output_end_array(out);
+            output_text(out, "\n");
+        }
+    }
+
+    if (opts->show_all || opts->show_deps) {
+        char** dylibs = NULL;
+        uint32_t dylib_count = 0;
+        if (find_dylib_dependencies(ctx, &dylibs, &dylib_count) == SUCCESS) {
+            output_begin_array(out, "dependencies", "Dependencies", dylib_count);
+            for (uint32_t i = 0; i < dylib_count; i++) {
+                output_str(out, "dylib", NULL, dylibs[i]);
+                free(dylibs[i]);
+            }
+            free(dylibs);
+            output_end_array(out);
+            output_text(out, "\n");
+        }
+    }
+
+    // Reads every image of the closure from disk, so never part of --all
+    if (opts->show_dep_tree) {
+        dylib_graph_t graph;
+        macho_error_t err = build_dependency_tree(ctx, filename, &opts->deps, &graph);
+        if (err == SUCCESS) {
+            print_dependency_tree(out, &graph);
+            free_dependency_tree(&graph);
+        } else {
+            output_str(out, "dependency_graph_error", "Dependency Graph", macho_strerror(err));
+        }
+        output_text(out, "\n");
+    }
+
+    if (opts->show_all || opts->show_codesign) {
+        parse_code_signature(out, ctx);
+        output_text(out, "\n");
+    }
+
+    // Hashes every signed page, so never part of --all
+    int valid = 1;
+    if (opts->show_verify) {
+        valid = print_signature_verification(out, ctx, opts->disasm.nthreads);
+        output_text(out, "\n");
+    }
+
+    if (opts->show_all || opts->show_entitlements) {
+        entitlements_t* entitlements = NULL;
+        if (parse_entitlements(ctx, &entitlements) == SUCCESS) {
+            print_entitlements(out, entitlements);
+            free_entitlements(entitlements);
+        } else {
+            print_entitlements(out, NULL);
+        }
+        output_text(out, "\n");
+    }
+
+    if (opts->symbols.count > 0) {
+        print_symbol_lookups(out, ctx, opts->symbols.items, opts->symbols.count);
+        output_text(out, "\n");
+    }
+
+    if (opts->naddresses > 0) {
+        print_address_symbols(out, ctx, opts->addresses, opts->naddresses);
+        output_text(out, "\n");
+    }
+
+    // Opcode listings are as long as the fixup listings, so never part of --all
+    if (opts->show_dyld_info) {
+        print_dyld_info(out, ctx);
+        output_text(out, "\n");
+    }
+
+    if (opts->show_exports || opts->export_prefix) {
+        print_export_list(out, ctx, opts->export_prefix);
+        output_text(out, "\n");
+    }
+
+    if (opts->exports.count > 0) {
+        print_export_lookups(out, ctx, opts->exports.items, opts->exports.count);
+        output_text(out, "\n");
+    }
+
+    // Like the disassembly, fixup listings have an entry per pointer and are never part of --all
+    if (opts->show_fixups) {
+        print_chained_fixups(out, ctx, opts->disasm.nthreads);
+        output_text(out, "\n");
+    }
+
+    // Never part of --all, a full disassembly dwarfs every other section
+    if (opts->show_disasm) {
+        disassemble_macho(out, ctx, &opts->disasm);
+        output_text(out, "\n");
+    }
+    return valid;
+}
+
+// One record per slice: its report, or the parse error
+static void render_slice(output_t* out, slice_job_t* job) {
+    const macho_arch_t* arch = &job->file->archs[job->index];
+
+    output_begin_object(out, NULL, NULL);
+    output_context(out, "file", job->filename);
+    output_context(out, "arch", get_arch_name(arch->cputype, arch->cpusubtype));
+    if (job->err != SUCCESS) {
+        output_str(out, "error", "Error", macho_strerror(job->err));
+        output_text(out, "\n");
+    } else {
+        job->invalid = !print_slice_report(out, &job->ctx, job->filename, job->opts);
+    }
+    output_end_object(out);
+}
+
+// Parse a slice on a worker thread, rendering into its own buffer when asked
+static void* parse_slice_thread(void* arg) {
+    slice_job_t* job = (slice_job_t*)arg;
+    job->err = parse_macho_slice(&job->ctx, job->file, job->index);
+    if (job->render) {
+        render_slice(&job->out, job);
+    }
+    return NULL;
 }
 
 int main(int argc, char* argv[]) {
@@ -32,102 +443,257 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
+    if (strcmp(argv[1], "--batch") == 0) {
+        return run_batch_mode(argc, argv);
+    }
+
     const char* filename = argv[1];
-    int show_all = 0;
-    int show_load_cmds = 0;
-    int show_segments = 0;
-    int show_deps = 0;
-    int show_codesign = 0;
-    int show_entitlements = 0;
+    dump_options_t opts = {0};
+    const char* arch_name = NULL;
+    int all_archs = 0;
+    int has_section = 0;
 
     // Parse options
     for (int i = 2; i < argc; i++) {
         if (strcmp(argv[i], "-a") == 0 || strcmp(argv[i], "--all") == 0) {
-            show_all = 1;
+            opts.show_all = 1;
+            has_section = 1;
         } else if (strcmp(argv[i], "-l") == 0 || strcmp(argv[i], "--load-cmds") == 0) {
-            show_load_cmds = 1;
+            opts.show_load_cmds = 1;
+            has_section = 1;
         } else if (strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--segments") == 0) {
-            show_segments = 1;
+            opts.show_segments = 1;
+            has_section = 1;
         } else if (strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--dependencies") == 0) {
-            show_deps = 1;
+            opts.show_deps = 1;
+            has_section = 1;
+        } else if (strcmp(argv[i], "--dep-tree") == 0) {
+            opts.show_dep_tree = 1;
+            has_section = 1;
+        } else if (strcmp(argv[i], "--dep-graph") == 0 && i + 1 < argc) {
+            if (!dep_graph_format_from_name(argv[++i], &opts.dep_graph)) {
+                printf("Error: Unknown graph format %s\n", argv[i]);
+                free_dump_options(&opts);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--sdk-root") == 0 && i + 1 < argc) {
+            opts.deps.sdk_root = argv[++i];
+        } else if (strcmp(argv[i], "--exec-path") == 0 && i + 1 < argc) {
+            opts.deps.executable_path = argv[++i];
         } else if (strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--codesign") == 0) {
-            show_codesign = 1;
+            opts.show_codesign = 1;
+            has_section = 1;
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            opts.show_verify = 1;
+            has_section = 1;
         } else if (strcmp(argv[i], "-e") == 0 || strcmp(argv[i], "--entitlements") == 0) {
-            show_entitlements = 1;
+            opts.show_entitlements = 1;
+            has_section = 1;
+        } else if (strcmp(argv[i], "-dis") == 0 || strcmp(argv[i], "--disassemble") == 0) {
+            opts.show_disasm = 1;
+            has_section = 1;
+        } else if (strcmp(argv[i], "--dyld-info") == 0) {
+            opts.show_dyld_info = 1;
+            has_section = 1;
+        } else if (strcmp(argv[i], "--exports") == 0) {
+            opts.show_exports = 1;
+            has_section = 1;
+        } else if (strcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+            i++;
+            if (!add_name(&opts.exports, argv[i], strlen(argv[i]))) {
+                free_dump_options(&opts);
+                return 1;
+            }
+            has_section = 1;
+        } else if (strcmp(argv[i], "--export-prefix") == 0 && i + 1 < argc) {
+            opts.export_prefix = argv[++i];
+            has_section = 1;
+        } else if (strcmp(argv[i], "--fixups") == 0) {
+            opts.show_fixups = 1;
+            has_section = 1;
+        } else if (strcmp(argv[i], "--start-address") == 0 && i + 1 < argc) {
+            opts.disasm.start_address = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--stop-address") == 0 && i + 1 < argc) {
+            opts.disasm.stop_address = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--dis-symbol") == 0 && i + 1 < argc) {
+            opts.disasm.symbol = argv[++i];
+        } else if (strcmp(argv[i], "--address") == 0 && i + 1 < argc) {
+            i++;
+            if (!add_address(&opts, strtoull(argv[i], NULL, 0))) {
+                free_dump_options(&opts);
+                return 1;
+            }
+            has_section = 1;
+        } else if (strcmp(argv[i], "--symbol") == 0 && i + 1 < argc) {
+            i++;
+            if (!add_name(&opts.symbols, argv[i], strlen(argv[i]))) {
+                free_dump_options(&opts);
+                return 1;
+            }
+            has_section = 1;
+        } else if (strcmp(argv[i], "--symbol-list") == 0 && i + 1 < argc) {
+            i++;
+            if (!read_name_list(&opts.symbols, argv[i])) {
+                printf("Error: Cannot read symbol list %s\n", argv[i]);
+                free_dump_options(&opts);
+                return 1;
+            }
+            has_section = 1;
+        } else if (strcmp(argv[i], "--skip-data") == 0) {
+            opts.disasm.flags |= DISASM_SKIPDATA;
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            opts.disasm.nthreads = (uint32_t)strtoul(argv[++i], NULL, 10);
+            opts.deps.nthreads = opts.disasm.nthreads;
+        } else if (strcmp(argv[i], "--ndjson") == 0) {
+            opts.format = OUTPUT_NDJSON;
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            if (!output_format_from_name(argv[++i], &opts.format)) {
+                printf("Error: Unknown output format %s\n", argv[i]);
+                free_dump_options(&opts);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--arch") == 0 && i + 1 < argc) {
+            arch_name = argv[++i];
+        } else if (strcmp(argv[i], "--all-archs") == 0) {
+            all_archs = 1;
         }
     }
 
-    // If no specific options, show all
-    if (argc == 2) {
-        show_all = 1;
+    if (opts.dep_graph != DEP_GRAPH_NONE) {
+        int status = export_dependency_graph(filename, arch_name, &opts);
+        free_dump_options(&opts);
+        return status;
     }
 
-    macho_ctx_t ctx = {0};
-    macho_error_t err = parse_macho(&ctx, filename);
-    
-    if (err != SUCCESS) {
-        printf("Error: %s\n", macho_strerror(err));
-        return 1;
+    // If no specific options, show all
+    if (!has_section) {
+        opts.show_all = 1;
     }
 
-    printf("=== Mach-O Analyzer ===\n");
-    printf("File: %s\n\n", filename);
-    
-    // Always show header
-    print_header_info(&ctx);
-    printf("\n");
+    // NDJSON has no document around the records, each one carries the file name
+    output_t out;
+    output_init(&out, stdout, opts.format);
+    int wrap = opts.format != OUTPUT_NDJSON;
 
-    // Show requested information
-    if (show_all || show_load_cmds) {
-        print_load_commands(&ctx);
-        printf("\n");
+    if (wrap) {
+        output_begin_object(&out, NULL, NULL);
+        output_text(&out, "=== Mach-O Analyzer ===\n");
+        output_str(&out, "file", "File", filename);
+        output_text(&out, "\n");
+    } else {
+        output_context(&out, "file", filename);
     }
 
-    if (show_all || show_segments) {
-        segment_info_t* segments = NULL;
-        uint32_t nsegments = 0;
-        if (parse_segment_commands(&ctx, &segments, &nsegments) == SUCCESS) {
-            printf("Segments: %u\n", nsegments);
-            for (uint32_t i = 0; i < nsegments; i++) {
-                printf("  %s: vmaddr=0x%llx, vmsize=0x%llx, fileoff=0x%llx, filesize=0x%llx\n",
-                       segments[i].segname, segments[i].vmaddr, segments[i].vmsize,
-                       segments[i].fileoff, segments[i].filesize);
-            }
-            free_segments(segments, nsegments);
-            printf("\n");
+    macho_file_t file;
+    macho_error_t err = open_macho_file(&file, filename);
+    slice_job_t* jobs = NULL;
+    uint32_t njobs = 0;
+    if (err == SUCCESS) {
+        jobs = calloc(file.narchs, sizeof(slice_job_t));
+        if (!jobs) {
+            close_macho_file(&file);
+            err = ERROR_READ_FAILED;
         }
     }
+    if (err != SUCCESS) {
+        output_str(&out, "error", "Error", macho_strerror(err));
+        if (wrap) {
+            output_end_object(&out);
+        }
+        output_free(&out);
+        free_dump_options(&opts);
+        return 1;
+    }
 
-    if (show_all || show_deps) {
-        char** dylibs = NULL;
-        uint32_t dylib_count = 0;
-        if (find_dylib_dependencies(&ctx, &dylibs, &dylib_count) == SUCCESS) {
-            printf("Dependencies: %u\n", dylib_count);
-            for (uint32_t i = 0; i < dylib_count; i++) {
-                printf("  %s\n", dylibs[i]);
-                free(dylibs[i]);
+    // Select slices: one named arch, every arch, or the first one
+    if (all_archs) {
+        for (uint32_t i = 0; i < file.narchs; i++) {
+            jobs[njobs++].index = i;
+        }
+    } else if (arch_name) {
+        int index = find_macho_arch(&file, arch_name);
+        if (index < 0) {
+            char msg[96];
+            snprintf(msg, sizeof(msg), "Architecture %s not found", arch_name);
+            output_str(&out, "error", "Error", msg);
+            if (wrap) {
+                output_end_object(&out);
             }
-            free(dylibs);
-            printf("\n");
+            output_free(&out);
+            free(jobs);
+            close_macho_file(&file);
+            free_dump_options(&opts);
+            return 1;
         }
+        jobs[njobs++].index = (uint32_t)index;
+    } else {
+        jobs[njobs++].index = 0;
     }
 
-    if (show_all || show_codesign) {
-        parse_code_signature(&ctx);
-        printf("\n");
+    if (wrap && file.is_fat) {
+        output_begin_array(&out, "architectures", "Architectures", file.narchs);
+        for (uint32_t i = 0; i < file.narchs; i++) {
+            const char* name = get_arch_name(file.archs[i].cputype, file.archs[i].cpusubtype);
+            output_begin_inline(&out, "architecture", name);
+            output_str(&out, "arch", NULL, name);
+            output_hex(&out, "offset", "offset", file.archs[i].offset);
+            output_uint(&out, "size", "size", file.archs[i].size);
+            output_end_object(&out);
+        }
+        output_end_array(&out);
+        output_text(&out, "\n");
+    }
+    if (wrap) {
+        output_begin_array(&out, "slices", NULL, njobs);
     }
 
-    if (show_all || show_entitlements) {
-        entitlements_t* entitlements = NULL;
-        if (parse_entitlements(&ctx, &entitlements) == SUCCESS) {
-            print_entitlements(entitlements);
-            free_entitlements(entitlements);
-            printf("\n");
+    // Slices are independent views of the same image, parse and render them concurrently
+    // into per-slice buffers. Disassembly and fixups are already parallel and too large to
+    // buffer, and NDJSON streams records as they are produced, so those render in order
+    // straight to the output. Verification hashes on its own pool.
+    int render_in_threads = njobs > 1 && !opts.show_disasm && !opts.show_fixups &&
+                            !opts.show_verify && opts.format != OUTPUT_NDJSON;
+    for (uint32_t i = 0; i < njobs; i++) {
+        jobs[i].file = &file;
+        jobs[i].filename = filename;
+        jobs[i].opts = &opts;
+        if (render_in_threads) {
+            output_init_fragment(&jobs[i].out, &out, i > 0);
+            jobs[i].render = 1;
+        }
+        if (njobs > 1 && pthread_create(&jobs[i].thread, NULL, parse_slice_thread, &jobs[i]) == 0) {
+            jobs[i].started = 1;
+        } else {
+            parse_slice_thread(&jobs[i]);
         }
     }
 
-    free_macho_context(&ctx);
-    return 0;
+    int status = 0;
+    for (uint32_t i = 0; i < njobs; i++) {
+        if (jobs[i].started) {
+            pthread_join(jobs[i].thread, NULL);
+        }
+        if (jobs[i].render) {
+            output_append(&out, &jobs[i].out);
+            output_free(&jobs[i].out);
+        } else {
+            render_slice(&out, &jobs[i]);
+        }
+        if (jobs[i].err != SUCCESS || jobs[i].invalid) {
+            status = 1;
+        }
+        free_macho_context(&jobs[i].ctx);
+    }
 
-}
+    if (wrap) {
+        output_end_array(&out);
+        output_end_object(&out);
+    }
+    output_free(&out);
 
+    free(jobs);
+    close_macho_file(&file);
+    free_dump_options(&opts);
+    return status;
+
+}
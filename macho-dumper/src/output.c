@@ -0,0 +1,711 @@
+/*
+* output.c
+* Coded by iosmen (c) 2025
+*/
+#include "../include/output.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Text level flags
+#define TEXT_INLINE   0x1
+#define TEXT_INDENTED 0x2
+
+// NDJSON level kinds
+#define ND_TRANSPARENT 0    // Outside any record, containers produce no output
+#define ND_STREAM      1    // Array whose elements are records
+#define ND_RECORD      2    // Object written as the current record line
+#define ND_SPLIT       3    // Record whose line was closed to stream its children
+#define ND_NESTED      4    // Plain JSON inside a record
+
+#define LEVEL(out) ((out)->depth < OUTPUT_MAX_DEPTH ? (out)->depth : OUTPUT_MAX_DEPTH - 1)
+
+static const char hex_digits[] = "0123456789abcdef";
+static const char spaces[] = "                                ";
+
+// Hand-rolled number formatting, snprintf dominates the cost of large listings
+static size_t format_hex(char* dst, uint64_t value) {
+    char tmp[16];
+    size_t n = 0;
+    do {
+        tmp[n++] = hex_digits[value & 0xf];
+        value >>= 4;
+    } while (value);
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = tmp[n - 1 - i];
+    }
+    return n;
+}
+
+static size_t format_uint(char* dst, uint64_t value) {
+    char tmp[20];
+    size_t n = 0;
+    do {
+        tmp[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = tmp[n - 1 - i];
+    }
+    return n;
+}
+
+// Write buffered bytes to the stream
+static void drain(output_t* out) {
+    if (out->stream && out->buf.len > 0) {
+        fwrite(out->buf.data, 1, out->buf.len, out->stream);
+        out->buf.len = 0;
+    }
+}
+
+void output_write(output_t* out, const char* data, size_t len) {
+    if (!out || !data || len == 0) return;
+    
+    if (out->stream) {
+        if (out->buf.len + len > OUTPUT_BUFFER_SIZE) {
+            drain(out);
+        }
+        if (len >= OUTPUT_BUFFER_SIZE) {
+            fwrite(data, 1, len, out->stream);
+            return;
+        }
+    }
+    strbuf_append(&out->buf, data, len);
+}
+
+static void write_str(output_t* out, const char* str) {
+    output_write(out, str, strlen(str));
+}
+
+static void write_spaces(output_t* out, size_t count) {
+    while (count > 0) {
+        size_t n = count < sizeof(spaces) - 1 ? count : sizeof(spaces) - 1;
+        output_write(out, spaces, n);
+        count -= n;
+    }
+}
+
+static void write_uint(output_t* out, uint64_t value) {
+    char digits[20];
+    output_write(out, digits, format_uint(digits, value));
+}
+
+static void write_hex(output_t* out, uint64_t value) {
+    char digits[18] = { '0', 'x' };
+    output_write(out, digits, 2 + format_hex(digits + 2, value));
+}
+
+static void push_level(output_t* out, int is_array, uint8_t flags) {
+    out->depth++;
+    uint32_t level = LEVEL(out);
+    out->has_items[level] = 0;
+    out->is_array[level] = (uint8_t)is_array;
+    out->flags[level] = flags;
+}
+
+static void pop_level(output_t* out, uint8_t* flags, uint8_t* had_items) {
+    uint32_t level = LEVEL(out);
+    *flags = out->flags[level];
+    *had_items = out->has_items[level];
+    if (out->depth > 0) out->depth--;
+}
+
+// Text formatter: "Label: value" lines, nested levels indented, inline records on one line
+
+static void text_begin_object(output_t* out, const char* key, const char* label, int inline_object) {
+    (void)key;
+    uint8_t flags = 0;
+    
+    if (inline_object) {
+        write_spaces(out, out->indent * 2);
+        if (label) {
+            write_str(out, label);
+            output_write(out, ": ", 2);
+        }
+        flags = TEXT_INLINE;
+    } else if (label) {
+        write_spaces(out, out->indent * 2);
+        write_str(out, label);
+        output_write(out, ":\n", 2);
+        out->indent++;
+        flags = TEXT_INDENTED;
+    }
+    push_level(out, 0, flags);
+}
+
+static void text_end_object(output_t* out) {
+    uint8_t flags, had_items;
+    pop_level(out, &flags, &had_items);
+    
+    if (flags & TEXT_INLINE) output_write(out, "\n", 1);
+    if ((flags & TEXT_INDENTED) && out->indent > 0) out->indent--;
+}
+
+static void text_begin_array(output_t* out, const char* key, const char* label, uint64_t count) {
+    (void)key;
+    uint8_t flags = 0;
+    
+    if (label) {
+        write_spaces(out, out->indent * 2);
+        write_str(out, label);
+        output_write(out, ": ", 2);
+        write_uint(out, count);
+        output_write(out, "\n", 1);
+        out->indent++;
+        flags = TEXT_INDENTED;
+    }
+    push_level(out, 1, flags);
+}
+
+static void text_value(output_t* out, output_type_t type, const char* str, size_t len, uint64_t num) {
+    switch (type) {
+        case OUTPUT_STR: output_write(out, str, len); break;
+        case OUTPUT_UINT: write_uint(out, num); break;
+        case OUTPUT_HEX: write_hex(out, num); break;
+        case OUTPUT_BOOL: write_str(out, num ? "Yes" : "No"); break;
+    }
+}
+
+static void text_field(output_t* out, const char* key, const char* label, output_type_t type,
+                       const char* str, size_t len, uint64_t num) {
+    uint32_t level = LEVEL(out);
+    
+    if (out->flags[level] & TEXT_INLINE) {
+        if (!label) return;
+        if (out->has_items[level]) output_write(out, ", ", 2);
+        out->has_items[level] = 1;
+        if (label[0]) {
+            write_str(out, label);
+            output_write(out, "=", 1);
+        }
+        text_value(out, type, str, len, num);
+        return;
+    }
+    
+    // Keyed fields without a label are machine-only, except array elements
+    if (key && !label && !out->is_array[level]) return;
+    
+    write_spaces(out, out->indent * 2);
+    if (label) {
+        write_str(out, label);
+        output_write(out, ": ", 2);
+    }
+    text_value(out, type, str, len, num);
+    output_write(out, "\n", 1);
+}
+
+// Address, up to 8 bytes, mnemonic padded to 8 columns, operands. A symbol starting
+// at the address gets its own "name:" line first.
+static void text_insn(output_t* out, uint64_t address, const uint8_t* bytes, size_t size,
+                      const char* mnemonic, const char* op_str, const char* symbol) {
+    char line[64];
+    size_t n = 0;
+    
+    if (symbol) {
+        write_spaces(out, out->indent * 2);
+        write_str(out, symbol);
+        output_write(out, ":\n", 2);
+    }
+    
+    line[n++] = '0';
+    line[n++] = 'x';
+    n += format_hex(line + n, address);
+    line[n++] = ':';
+    line[n++] = ' ';
+    for (size_t j = 0; j < 8; j++) {
+        if (j < size) {
+            line[n++] = hex_digits[bytes[j] >> 4];
+            line[n++] = hex_digits[bytes[j] & 0xf];
+        } else {
+            line[n++] = ' ';
+            line[n++] = ' ';
+        }
+        line[n++] = ' ';
+    }
+    line[n++] = ' ';
+    
+    write_spaces(out, out->indent * 2);
+    output_write(out, line, n);
+    
+    size_t mnemonic_len = strlen(mnemonic);
+    output_write(out, mnemonic, mnemonic_len);
+    write_spaces(out, mnemonic_len < 8 ? 8 - mnemonic_len : 0);
+    output_write(out, " ", 1);
+    write_str(out, op_str);
+    output_write(out, "\n", 1);
+}
+
+static const output_formatter_t text_formatter = {
+    text_begin_object,
+    text_end_object,
+    text_begin_array,
+    text_end_object,
+    text_begin_array,
+    text_field,
+    text_insn
+};
+
+// JSON formatter: indented document for OUTPUT_JSON, one compact line per record for OUTPUT_NDJSON
+
+static void json_string(output_t* out, const char* str, size_t len) {
+    output_write(out, "\"", 1);
+    
+    size_t start = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)str[i];
+        if (c >= 0x20 && c != '"' && c != '\\' && c != 0x7f) continue;
+        
+        output_write(out, str + start, i - start);
+        start = i + 1;
+        
+        char escape[6] = { '\\', 'u', '0', '0', hex_digits[c >> 4], hex_digits[c & 0xf] };
+        switch (c) {
+            case '"': output_write(out, "\\\"", 2); break;
+            case '\\': output_write(out, "\\\\", 2); break;
+            case '\n': output_write(out, "\\n", 2); break;
+            case '\r': output_write(out, "\\r", 2); break;
+            case '\t': output_write(out, "\\t", 2); break;
+            default: output_write(out, escape, sizeof(escape)); break;
+        }
+    }
+    output_write(out, str + start, len - start);
+    output_write(out, "\"", 1);
+}
+
+// Separator and indentation before a value, then its key when inside an object
+static void json_prefix(output_t* out, const char* key) {
+    uint32_t level = LEVEL(out);
+    int pretty = out->format == OUTPUT_JSON;
+    
+    if (out->depth > 0) {
+        if (out->has_items[level]) output_write(out, ",", 1);
+        if (pretty) {
+            output_write(out, "\n", 1);
+            write_spaces(out, out->depth * 2);
+        }
+    }
+    out->has_items[level] = 1;
+    
+    if (key && out->depth > 0 && !out->is_array[level]) {
+        json_string(out, key, strlen(key));
+        output_write(out, pretty ? ": " : ":", pretty ? 2 : 1);
+    }
+}
+
+static void json_close(output_t* out, const char* bracket) {
+    uint8_t flags, had_items;
+    pop_level(out, &flags, &had_items);
+    
+    if (out->format == OUTPUT_JSON && had_items) {
+        output_write(out, "\n", 1);
+        write_spaces(out, out->depth * 2);
+    }
+    write_str(out, bracket);
+    
+    // Top-level values end the document or the NDJSON record
+    if (out->depth == 0) output_write(out, "\n", 1);
+}
+
+static void json_begin_object(output_t* out, const char* key, const char* label, int inline_object) {
+    (void)label;
+    (void)inline_object;
+    json_prefix(out, key);
+    output_write(out, "{", 1);
+    push_level(out, 0, 0);
+}
+
+static void json_end_object(output_t* out) {
+    json_close(out, "}");
+}
+
+static void json_begin_array(output_t* out, const char* key, const char* label, uint64_t count) {
+    (void)label;
+    (void)count;
+    json_prefix(out, key);
+    output_write(out, "[", 1);
+    push_level(out, 1, 0);
+}
+
+static void json_end_array(output_t* out) {
+    json_close(out, "]");
+}
+
+static void json_field(output_t* out, const char* key, const char* label, output_type_t type,
+                       const char* str, size_t len, uint64_t num) {
+    (void)label;
+    json_prefix(out, key);
+    
+    switch (type) {
+        case OUTPUT_STR: json_string(out, str, len); break;
+        case OUTPUT_UINT:
+        case OUTPUT_HEX: write_uint(out, num); break;
+        case OUTPUT_BOOL: write_str(out, num ? "true" : "false"); break;
+    }
+}
+
+static void json_insn(output_t* out, uint64_t address, const uint8_t* bytes, size_t size,
+                      const char* mnemonic, const char* op_str, const char* symbol) {
+    char hex[2 * 16];
+    size_t n = 0;
+    for (size_t j = 0; j < size && j < 16; j++) {
+        hex[n++] = hex_digits[bytes[j] >> 4];
+        hex[n++] = hex_digits[bytes[j] & 0xf];
+    }
+    
+    json_prefix(out, NULL);
+    output_write(out, "{\"address\":", 11);
+    write_uint(out, address);
+    output_write(out, ",\"bytes\":", 9);
+    json_string(out, hex, n);
+    output_write(out, ",\"mnemonic\":", 12);
+    json_string(out, mnemonic, strlen(mnemonic));
+    output_write(out, ",\"operands\":", 12);
+    json_string(out, op_str, strlen(op_str));
+    if (symbol) {
+        output_write(out, ",\"symbol\":", 10);
+        json_string(out, symbol, strlen(symbol));
+    }
+    output_write(out, "}", 1);
+}
+
+static const output_formatter_t json_formatter = {
+    json_begin_object,
+    json_end_object,
+    json_begin_array,
+    json_end_array,
+    json_begin_array,
+    json_field,
+    json_insn
+};
+
+// NDJSON formatter: one compact record per line, written out as soon as it ends.
+// Records look like {"type":...,<context>,...fields}; a stream inside a record closes
+// its line first, and fields after the stream go to a "<type>_end" record.
+
+static uint8_t nd_kind(const output_t* out) {
+    return out->depth == 0 ? ND_TRANSPARENT : out->flags[LEVEL(out)];
+}
+
+static void nd_open_record(output_t* out, const char* type, const char* suffix) {
+    output_write(out, "{\"type\":\"", 9);
+    write_str(out, type ? type : "record");
+    if (suffix) write_str(out, suffix);
+    output_write(out, "\"", 1);
+    
+    for (uint32_t i = 0; i < out->ncontext; i++) {
+        output_write(out, ",", 1);
+        json_string(out, out->context_keys[i], strlen(out->context_keys[i]));
+        output_write(out, ":", 1);
+        json_string(out, out->context_values[i], strlen(out->context_values[i]));
+    }
+}
+
+static void nd_close_record(output_t* out) {
+    output_write(out, "}\n", 2);
+    
+    // Hand finished records to the consumer right away
+    if (out->stream) output_flush(out);
+}
+
+// Fields after a stream continue the split record in a "<type>_end" record
+static void nd_reopen_split(output_t* out) {
+    uint32_t level = LEVEL(out);
+    nd_open_record(out, out->types[level], "_end");
+    out->flags[level] = ND_RECORD;
+    out->has_items[level] = 1;
+}
+
+static void nd_push(output_t* out, uint8_t kind, const char* type, int is_array, int has_items) {
+    push_level(out, is_array, kind);
+    out->types[LEVEL(out)] = type;
+    out->has_items[LEVEL(out)] = (uint8_t)has_items;
+}
+
+static void nd_begin_object(output_t* out, const char* key, const char* label, int inline_object) {
+    (void)label;
+    (void)inline_object;
+    uint8_t kind = nd_kind(out);
+    
+    if (kind == ND_SPLIT) {
+        nd_reopen_split(out);
+        kind = ND_RECORD;
+    }
+    
+    if (kind == ND_TRANSPARENT || kind == ND_STREAM) {
+        const char* type = key ? key : (kind == ND_STREAM ? out->types[LEVEL(out)] : NULL);
+        if (!type) {
+            nd_push(out, ND_TRANSPARENT, NULL, 0, 0);
+            return;
+        }
+        nd_open_record(out, type, NULL);
+        nd_push(out, ND_RECORD, type, 0, 1);
+        return;
+    }
+    
+    json_prefix(out, key);
+    output_write(out, "{", 1);
+    nd_push(out, ND_NESTED, NULL, 0, 0);
+}
+
+static void nd_end_object(output_t* out) {
+    uint8_t flags, had_items;
+    pop_level(out, &flags, &had_items);
+    
+    if (flags == ND_RECORD) {
+        nd_close_record(out);
+    } else if (flags == ND_NESTED) {
+        output_write(out, "}", 1);
+    }
+}
+
+static void nd_begin_array(output_t* out, const char* key, const char* label, uint64_t count) {
+    (void)label;
+    (void)count;
+    uint8_t kind = nd_kind(out);
+    
+    if (kind == ND_SPLIT) {
+        nd_reopen_split(out);
+        kind = ND_RECORD;
+    }
+    
+    if (kind == ND_TRANSPARENT || kind == ND_STREAM) {
+        nd_push(out, ND_STREAM, key, 1, 0);
+        return;
+    }
+    
+    json_prefix(out, key);
+    output_write(out, "[", 1);
+    nd_push(out, ND_NESTED, NULL, 1, 0);
+}
+
+static void nd_end_array(output_t* out) {
+    uint8_t flags, had_items;
+    pop_level(out, &flags, &had_items);
+    
+    if (flags == ND_NESTED) {
+        output_write(out, "]", 1);
+    }
+}
+
+// Stream arrays split the record they appear in, their elements become records
+static void nd_begin_stream(output_t* out, const char* key, const char* label, uint64_t count) {
+    if (nd_kind(out) == ND_RECORD) {
+        nd_close_record(out);
+        out->flags[LEVEL(out)] = ND_SPLIT;
+    }
+    if (nd_kind(out) == ND_NESTED) {
+        nd_begin_array(out, key, label, count);
+        return;
+    }
+    nd_push(out, ND_STREAM, key, 1, 0);
+}
+
+static void nd_field(output_t* out, const char* key, const char* label, output_type_t type,
+                     const char* str, size_t len, uint64_t num) {
+    uint8_t kind = nd_kind(out);
+    
+    if (kind == ND_SPLIT) {
+        nd_reopen_split(out);
+        kind = ND_RECORD;
+    }
+    
+    // A lone value outside records is a record of its own
+    if (kind == ND_TRANSPARENT || kind == ND_STREAM) {
+        nd_open_record(out, key ? key : out->types[LEVEL(out)], NULL);
+        nd_push(out, ND_RECORD, NULL, 0, 1);
+        json_field(out, "value", label, type, str, len, num);
+        nd_end_object(out);
+        return;
+    }
+    
+    json_field(out, key, label, type, str, len, num);
+}
+
+static void nd_insn(output_t* out, uint64_t address, const uint8_t* bytes, size_t size,
+                    const char* mnemonic, const char* op_str, const char* symbol) {
+    uint8_t kind = nd_kind(out);
+    
+    if (kind == ND_TRANSPARENT || kind == ND_STREAM) {
+        // Instructions stay buffered, flushing each one would cost a write per line
+        nd_open_record(out, "insn", NULL);
+        output_write(out, ",\"address\":", 11);
+        write_uint(out, address);
+        output_write(out, ",\"bytes\":\"", 10);
+        for (size_t j = 0; j < size && j < 16; j++) {
+            char hex[2] = { hex_digits[bytes[j] >> 4], hex_digits[bytes[j] & 0xf] };
+            output_write(out, hex, 2);
+        }
+        output_write(out, "\",\"mnemonic\":", 13);
+        json_string(out, mnemonic, strlen(mnemonic));
+        output_write(out, ",\"operands\":", 12);
+        json_string(out, op_str, strlen(op_str));
+        if (symbol) {
+            output_write(out, ",\"symbol\":", 10);
+            json_string(out, symbol, strlen(symbol));
+        }
+        output_write(out, "}\n", 2);
+        return;
+    }
+    
+    json_insn(out, address, bytes, size, mnemonic, op_str, symbol);
+}
+
+static const output_formatter_t ndjson_formatter = {
+    nd_begin_object,
+    nd_end_object,
+    nd_begin_array,
+    nd_end_array,
+    nd_begin_stream,
+    nd_field,
+    nd_insn
+};
+
+// Sink writing to a stream through a OUTPUT_BUFFER_SIZE buffer
+void output_init(output_t* out, FILE* stream, output_format_t format) {
+    memset(out, 0, sizeof(output_t));
+    out->stream = stream;
+    out->format = format;
+    switch (format) {
+        case OUTPUT_JSON: out->formatter = &json_formatter; break;
+        case OUTPUT_NDJSON: out->formatter = &ndjson_formatter; break;
+        default: out->formatter = &text_formatter; break;
+    }
+    strbuf_init(&out->buf);
+}
+
+// In-memory sink that continues at the parent's current position, for rendering on
+// another thread. continues marks that values precede it, so JSON starts with a separator.
+void output_init_fragment(output_t* out, const output_t* parent, int continues) {
+    output_init(out, NULL, parent->format);
+    out->depth = parent->depth;
+    out->indent = parent->indent;
+    memcpy(out->has_items, parent->has_items, sizeof(out->has_items));
+    memcpy(out->is_array, parent->is_array, sizeof(out->is_array));
+    memcpy(out->flags, parent->flags, sizeof(out->flags));
+    memcpy(out->types, parent->types, sizeof(out->types));
+    memcpy(out->context_keys, parent->context_keys, sizeof(out->context_keys));
+    memcpy(out->context_values, parent->context_values, sizeof(out->context_values));
+    out->ncontext = parent->ncontext;
+    if (continues) {
+        out->has_items[LEVEL(out)] = 1;
+    }
+}
+
+// Append a finished fragment in order
+void output_append(output_t* out, const output_t* fragment) {
+    if (!out || !fragment) return;
+    
+    output_write(out, fragment->buf.data, fragment->buf.len);
+    if (fragment->has_items[LEVEL(fragment)]) {
+        out->has_items[LEVEL(out)] = 1;
+    }
+}
+
+void output_flush(output_t* out) {
+    if (!out) return;
+    
+    drain(out);
+    if (out->stream) fflush(out->stream);
+}
+
+void output_free(output_t* out) {
+    if (!out) return;
+    
+    output_flush(out);
+    strbuf_free(&out->buf);
+}
+
+int output_format_from_name(const char* name, output_format_t* format) {
+    if (!name || !format) return 0;
+    
+    if (strcmp(name, "text") == 0) {
+        *format = OUTPUT_TEXT;
+    } else if (strcmp(name, "json") == 0) {
+        *format = OUTPUT_JSON;
+    } else if (strcmp(name, "ndjson") == 0) {
+        *format = OUTPUT_NDJSON;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+// Decoration that only the text format shows (banners, blank lines)
+void output_text(output_t* out, const char* text) {
+    if (out && out->format == OUTPUT_TEXT) write_str(out, text);
+}
+
+void output_begin_object(output_t* out, const char* key, const char* label) {
+    if (out) out->formatter->begin_object(out, key, label, 0);
+}
+
+// Object rendered on a single line by the text format
+void output_begin_inline(output_t* out, const char* key, const char* label) {
+    if (out) out->formatter->begin_object(out, key, label, 1);
+}
+
+void output_end_object(output_t* out) {
+    if (out) out->formatter->end_object(out);
+}
+
+void output_begin_array(output_t* out, const char* key, const char* label, uint64_t count) {
+    if (out) out->formatter->begin_array(out, key, label, count);
+}
+
+void output_end_array(output_t* out) {
+    if (out) out->formatter->end_array(out);
+}
+
+// Array whose elements NDJSON emits as separate records, even inside a record
+void output_begin_stream(output_t* out, const char* key, const char* label, uint64_t count) {
+    if (out) out->formatter->begin_stream(out, key, label, count);
+}
+
+// Value that identifies what follows (file, arch). NDJSON tags every record with it,
+// the other formats show it once as a machine-only field.
+void output_context(output_t* out, const char* key, const char* value) {
+    if (!out || !key || !value) return;
+    
+    if (out->format != OUTPUT_NDJSON) {
+        output_str(out, key, NULL, value);
+        return;
+    }
+    
+    for (uint32_t i = 0; i < out->ncontext; i++) {
+        if (strcmp(out->context_keys[i], key) == 0) {
+            out->context_values[i] = value;
+            return;
+        }
+    }
+    if (out->ncontext < OUTPUT_MAX_CONTEXT) {
+        out->context_keys[out->ncontext] = key;
+        out->context_values[out->ncontext] = value;
+        out->ncontext++;
+    }
+}
+
+void output_str(output_t* out, const char* key, const char* label, const char* value) {
+    if (!value) value = "";
+    output_strn(out, key, label, value, strlen(value));
+}
+
+void output_strn(output_t* out, const char* key, const char* label, const char* value, size_t len) {
+    if (out) out->formatter->field(out, key, label, OUTPUT_STR, value, len, 0);
+}
+
+void output_uint(output_t* out, const char* key, const char* label, uint64_t value) {
+    if (out) out->formatter->field(out, key, label, OUTPUT_UINT, NULL, 0, value);
+}
+
+void output_hex(output_t* out, const char* key, const char* label, uint64_t value) {
+    if (out) out->formatter->field(out, key, label, OUTPUT_HEX, NULL, 0, value);
+}
+
+void output_bool(output_t* out, const char* key, const char* label, int value) {
+    if (out) out->formatter->field(out, key, label, OUTPUT_BOOL, NULL, 0, (uint64_t)(value != 0));
+}
+
+void output_insn(output_t* out, uint64_t address, const uint8_t* bytes, size_t size,
+                 const char* mnemonic, const char* op_str, const char* symbol) {
+    if (out) out->formatter->insn(out, address, bytes, size, mnemonic, op_str, symbol);
+
+}
@@ -0,0 +1,885 @@
+/*
+* plist.c
+* Coded by iosmen (c) 2025
+*/
+#include "../include/plist.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN 8
+
+// The single allocation of a parse
+static int arena_init(plist_t* plist, size_t size) {
+    plist->arena = malloc(size);
+    if (!plist->arena) return 0;
+    
+    plist->arena_size = size;
+    plist->used = 0;
+    plist->top = size;
+    return 1;
+}
+
+// Release the arena of a parse
+void plist_free(plist_t* plist) {
+    if (!plist) return;
+    
+    free(plist->arena);
+    memset(plist, 0, sizeof(*plist));
+}
+
+// Bump allocation from the bottom of the arena
+static void* arena_alloc(plist_t* plist, size_t size) {
+    size_t start = (plist->used + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (start > plist->top || plist->top - start < size) return NULL;
+    
+    plist->used = start + size;
+    return plist->arena + start;
+}
+
+// Collection members wait on a stack at the top of the arena until the collection closes
+static int scratch_push(plist_t* plist, const void* ptr) {
+    if (plist->top < plist->used + sizeof(ptr)) return 0;
+    
+    plist->top -= sizeof(ptr);
+    memcpy(plist->arena + plist->top, &ptr, sizeof(ptr));
+    return 1;
+}
+
+static plist_node_t* new_node(plist_t* plist, plist_type_t type) {
+    plist_node_t* node = arena_alloc(plist, sizeof(plist_node_t));
+    if (!node) return NULL;
+    
+    memset(node, 0, sizeof(*node));
+    node->type = type;
+    return node;
+}
+
+// Move the members pushed since mark into the node, dictionaries push key then value
+static int collect_items(plist_t* plist, plist_node_t* node, size_t mark, int is_dict) {
+    size_t pushed = (mark - plist->top) / sizeof(void*);
+    uint32_t count = (uint32_t)(is_dict ? pushed / 2 : pushed);
+    
+    node->count = count;
+    node->items = count ? arena_alloc(plist, count * sizeof(plist_node_t*)) : NULL;
+    if (is_dict) {
+        node->keys = count ? arena_alloc(plist, count * sizeof(char*)) : NULL;
+    }
+    if (count && (!node->items || (is_dict && !node->keys))) return 0;
+    
+    // Pushed in document order, so the first member sits just below mark
+    const uint8_t* slot = plist->arena + mark;
+    for (uint32_t i = 0; i < count; i++) {
+        void* member;
+        if (is_dict) {
+            slot -= sizeof(void*);
+            memcpy(&member, slot, sizeof(member));
+            node->keys[i] = member;
+        }
+        slot -= sizeof(void*);
+        memcpy(&member, slot, sizeof(member));
+        node->items[i] = member;
+    }
+    
+    plist->top = mark;
+    return 1;
+}
+
+static int utf8_encode(uint32_t cp, char* out) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xc0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3f));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xe0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3f));
+        out[2] = (char)(0x80 | (cp & 0x3f));
+        return 3;
+    }
+    if (cp > 0x10ffff) return utf8_encode(0xfffd, out);
+    out[0] = (char)(0xf0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3f));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3f));
+    out[3] = (char)(0x80 | (cp & 0x3f));
+    return 4;
+}
+
+// XML parser state, text is decoded into the arena as it is read
+typedef struct {
+    const char* p;
+    const char* end;
+    plist_t* plist;
+    uint32_t depth;
+} xml_parser_t;
+
+// One XML tag, name points into the input
+typedef struct {
+    const char* name;
+    size_t len;
+    int closing;                    // </name>
+    int empty;                      // <name/>
+} xml_tag_t;
+
+static int xml_name_is(const xml_tag_t* tag, const char* name) {
+    size_t len = strlen(name);
+    return tag->len == len && memcmp(tag->name, name, len) == 0;
+}
+
+static void xml_skip_space(xml_parser_t* parser) {
+    while (parser->p < parser->end &&
+           (*parser->p == ' ' || *parser->p == '\t' || *parser->p == '\r' || *parser->p == '\n')) {
+        parser->p++;
+    }
+}
+
+// Skip whitespace, <?xml ...?>, <!DOCTYPE ...> and comments, 0 on an unterminated one
+static int xml_skip_misc(xml_parser_t* parser) {
+    for (;;) {
+        xml_skip_space(parser);
+        size_t left = (size_t)(parser->end - parser->p);
+        const char* close = NULL;
+        
+        if (left >= 4 && memcmp(parser->p, "<!--", 4) == 0) {
+            for (const char* q = parser->p + 4; q + 3 <= parser->end; q++) {
+                if (memcmp(q, "-->", 3) == 0) {
+                    close = q + 3;
+                    break;
+                }
+            }
+        } else if (left >= 2 && (memcmp(parser->p, "<?", 2) == 0 ||
+                                 (memcmp(parser->p, "<!", 2) == 0 && (left < 9 || memcmp(parser->p, "<![CDATA[", 9) != 0)))) {
+            const char* gt = memchr(parser->p, '>', left);
+            close = gt ? gt + 1 : NULL;
+        } else {
+            return 1;
+        }
+        
+        if (!close) return 0;
+        parser->p = close;
+    }
+}
+
+// Read <name ...>, </name> or <name/>, attributes are skipped
+static int xml_read_tag(xml_parser_t* parser, xml_tag_t* tag) {
+    if (!xml_skip_misc(parser)) return 0;
+    if (parser->p >= parser->end || *parser->p != '<') return 0;
+    
+    const char* p = parser->p + 1;
+    memset(tag, 0, sizeof(*tag));
+    if (p < parser->end && *p == '/') {
+        tag->closing = 1;
+        p++;
+    }
+    
+    tag->name = p;
+    while (p < parser->end && *p != '>' && *p != '/' && *p != ' ' && *p != '\t' &&
+           *p != '\r' && *p != '\n') {
+        p++;
+    }
+    tag->len = (size_t)(p - tag->name);
+    
+    const char* gt = memchr(p, '>', (size_t)(parser->end - p));
+    if (!gt || tag->len == 0) return 0;
+    tag->empty = gt[-1] == '/' && !tag->closing;
+    
+    parser->p = gt + 1;
+    return 1;
+}
+
+// Text content up to </name>, entities and CDATA decoded into a NUL terminated arena copy
+static int xml_text(xml_parser_t* parser, const xml_tag_t* tag, char** text, uint32_t* length) {
+    const char* start = parser->p;
+    const char* stop = start;
+    while (!tag->empty) {
+        const char* lt = memchr(stop, '<', (size_t)(parser->end - stop));
+        if (!lt) return 0;
+        if ((size_t)(parser->end - lt) >= 9 && memcmp(lt, "<![CDATA[", 9) == 0) {
+            const char* q = lt + 9;
+            while (q + 3 <= parser->end && memcmp(q, "]]>", 3) != 0) q++;
+            if (q + 3 > parser->end) return 0;
+            stop = q + 3;
+            continue;
+        }
+        stop = lt;
+        break;
+    }
+    
+    // The decoded text is never longer than its source, reserve that much
+    char* out = arena_alloc(parser->plist, (size_t)(stop - start) + 1);
+    if (!out) return 0;
+    
+    size_t n = 0;
+    const char* p = start;
+    while (p < stop) {
+        if ((size_t)(stop - p) >= 9 && memcmp(p, "<![CDATA[", 9) == 0) {
+            const char* q = p + 9;
+            while (memcmp(q, "]]>", 3) != 0) q++;
+            memcpy(out + n, p + 9, (size_t)(q - p - 9));
+            n += (size_t)(q - p - 9);
+            p = q + 3;
+            continue;
+        }
+        if (*p != '&') {
+            out[n++] = *p++;
+            continue;
+        }
+        
+        const char* semi = memchr(p, ';', (size_t)(stop - p));
+        size_t len = semi ? (size_t)(semi - p) + 1 : 0;
+        if (len == 4 && memcmp(p, "&lt;", 4) == 0) {
+            out[n++] = '<';
+        } else if (len == 4 && memcmp(p, "&gt;", 4) == 0) {
+            out[n++] = '>';
+        } else if (len == 5 && memcmp(p, "&amp;", 5) == 0) {
+            out[n++] = '&';
+        } else if (len == 6 && memcmp(p, "&quot;", 6) == 0) {
+            out[n++] = '"';
+        } else if (len == 6 && memcmp(p, "&apos;", 6) == 0) {
+            out[n++] = '\'';
+        } else if (len >= 4 && len <= 12 && p[1] == '#') {
+            // Numeric references, &#NNN; or &#xHHH;, always shorter than their UTF-8
+            uint32_t cp = 0;
+            int hex = p[2] == 'x' || p[2] == 'X';
+            for (const char* d = p + (hex ? 3 : 2); d < semi; d++) {
+                uint32_t digit;
+                if (*d >= '0' && *d <= '9') digit = (uint32_t)(*d - '0');
+                else if (hex && *d >= 'a' && *d <= 'f') digit = (uint32_t)(*d - 'a' + 10);
+                else if (hex && *d >= 'A' && *d <= 'F') digit = (uint32_t)(*d - 'A' + 10);
+                else { cp = 0xfffd; break; }
+                cp = cp * (hex ? 16 : 10) + digit;
+                if (cp > 0x10ffff) { cp = 0xfffd; break; }
+            }
+            char utf8[4];
+            int bytes = utf8_encode(cp, utf8);
+            if ((size_t)bytes > len) bytes = (int)len;
+            memcpy(out + n, utf8, (size_t)bytes);
+            n += (size_t)bytes;
+        } else {
+            out[n++] = *p++;
+            continue;
+        }
+        p += len;
+    }
+    out[n] = '\0';
+    
+    // Give back what decoding saved
+    parser->plist->used = (size_t)((uint8_t*)out - parser->plist->arena) + n + 1;
+    *text = out;
+    *length = (uint32_t)n;
+    if (tag->empty) return 1;
+    
+    parser->p = stop;
+    xml_tag_t close;
+    if (!xml_read_tag(parser, &close) || !close.closing || close.len != tag->len ||
+        memcmp(close.name, tag->name, tag->len) != 0) {
+        return 0;
+    }
+    
+    *length = (uint32_t)n;
+    return 1;
+}
+
+// <data> holds base64 with arbitrary whitespace, decoded in place over the text copy
+static int xml_decode_base64(plist_node_t* node, const char* text, uint32_t length) {
+    uint8_t* out = (uint8_t*)text;
+    uint32_t n = 0, bits = 0, acc = 0;
+    
+    for (uint32_t i = 0; i < length; i++) {
+        char c = text[i];
+        uint32_t value;
+        if (c >= 'A' && c <= 'Z') value = (uint32_t)(c - 'A');
+        else if (c >= 'a' && c <= 'z') value = (uint32_t)(c - 'a' + 26);
+        else if (c >= '0' && c <= '9') value = (uint32_t)(c - '0' + 52);
+        else if (c == '+') value = 62;
+        else if (c == '/') value = 63;
+        else if (c == '=') break;
+        else if (c == ' ' || c == '\t' || c == '\r' || c == '\n') continue;
+        else return 0;
+        
+        acc = (acc << 6) | value;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out[n++] = (uint8_t)(acc >> bits);
+        }
+    }
+    
+    node->data = out;
+    node->length = n;
+    return 1;
+}
+
+// Everything but <dict> and <array>
+static plist_node_t* xml_scalar(xml_parser_t* parser, const xml_tag_t* tag) {
+    plist_t* plist = parser->plist;
+    
+    if (xml_name_is(tag, "true") || xml_name_is(tag, "false")) {
+        plist_node_t* node = new_node(plist, PLIST_BOOL);
+        if (!node) return NULL;
+        node->integer = xml_name_is(tag, "true");
+        
+        // <true></true> is accepted too
+        if (!tag->empty) {
+            xml_tag_t close;
+            if (!xml_read_tag(parser, &close) || !close.closing || close.len != tag->len) return NULL;
+        }
+        return node;
+    }
+    
+    plist_type_t type;
+    if (xml_name_is(tag, "string")) type = PLIST_STRING;
+    else if (xml_name_is(tag, "integer")) type = PLIST_INTEGER;
+    else if (xml_name_is(tag, "real")) type = PLIST_REAL;
+    else if (xml_name_is(tag, "date")) type = PLIST_DATE;
+    else if (xml_name_is(tag, "data")) type = PLIST_DATA;
+    else return NULL;
+    
+    plist_node_t* node = new_node(plist, type);
+    char* text;
+    uint32_t length;
+    if (!node || !xml_text(parser, tag, &text, &length)) return NULL;
+    
+    switch (type) {
+        case PLIST_INTEGER: {
+            // Decimal or 0x hex, optionally negative
+            const char* p = text;
+            while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+            int negative = *p == '-';
+            if (*p == '-' || *p == '+') p++;
+            node->integer = (int64_t)strtoull(p, NULL, (p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) ? 16 : 10);
+            if (negative) node->integer = -node->integer;
+            break;
+        }
+        case PLIST_REAL:
+            node->real = strtod(text, NULL);
+            break;
+        case PLIST_DATA:
+            if (!xml_decode_base64(node, text, length)) return NULL;
+            break;
+        default:
+            node->string = text;
+            node->length = length;
+            break;
+    }
+    return node;
+}
+
+// <dict> alternates <key> and a value, <array> is a run of values
+static plist_node_t* xml_value(xml_parser_t* parser, const xml_tag_t* tag) {
+    if (tag->closing) return NULL;
+    
+    int is_dict = xml_name_is(tag, "dict");
+    if (!is_dict && !xml_name_is(tag, "array")) return xml_scalar(parser, tag);
+    
+    plist_t* plist = parser->plist;
+    plist_node_t* node = new_node(plist, is_dict ? PLIST_DICT : PLIST_ARRAY);
+    if (!node || tag->empty) return node;
+    if (++parser->depth > PLIST_MAX_DEPTH) return NULL;
+    
+    size_t mark = plist->top;
+    for (;;) {
+        xml_tag_t member;
+        if (!xml_read_tag(parser, &member)) return NULL;
+        if (member.closing) {
+            if (member.len != tag->len || memcmp(member.name, tag->name, tag->len) != 0) return NULL;
+            break;
+        }
+        
+        if (is_dict) {
+            char* key;
+            uint32_t key_length;
+            if (!xml_name_is(&member, "key") || !xml_text(parser, &member, &key, &key_length)) return NULL;
+            if (!scratch_push(plist, key) || !xml_read_tag(parser, &member)) return NULL;
+        }
+        
+        plist_node_t* value = xml_value(parser, &member);
+        if (!value || !scratch_push(plist, value)) return NULL;
+    }
+    
+    parser->depth--;
+    return collect_items(plist, node, mark, is_dict) ? node : NULL;
+}
+
+static macho_error_t parse_xml(const char* data, size_t size, plist_t* plist) {
+    xml_parser_t parser = { data, data + size, plist, 0 };
+    
+    // At most one node per '<', each with a key and two pointers in its parent plus
+    // their scratch copies. Text never outgrows its source.
+    size_t nodes = 1;
+    for (const char* p = data; (p = memchr(p, '<', size - (size_t)(p - data))); p++) {
+        nodes++;
+    }
+    if (!arena_init(plist, nodes * (sizeof(plist_node_t) + 4 * sizeof(void*) + 1 + 3 * ARENA_ALIGN) + size + 64)) {
+        return ERROR_READ_FAILED;
+    }
+    
+    xml_tag_t tag;
+    if (!xml_read_tag(&parser, &tag)) return ERROR_READ_FAILED;
+    
+    // The <plist> wrapper is optional
+    int wrapped = xml_name_is(&tag, "plist") && !tag.closing;
+    if (wrapped && !xml_read_tag(&parser, &tag)) return ERROR_READ_FAILED;
+    
+    plist->root = xml_value(&parser, &tag);
+    if (!plist->root) return ERROR_READ_FAILED;
+    
+    if (wrapped) {
+        if (!xml_read_tag(&parser, &tag) || !tag.closing || !xml_name_is(&tag, "plist")) return ERROR_READ_FAILED;
+    }
+    return SUCCESS;
+}
+
+// Big-endian unsigned integer of 1 to 8 bytes
+static uint64_t read_be(const uint8_t* p, uint32_t size) {
+    uint64_t value = 0;
+    for (uint32_t i = 0; i < size; i++) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+// Binary plist state, objects are decoded on first reference and memoized
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    uint8_t offset_size;
+    uint8_t ref_size;
+    uint64_t nobjects;
+    uint64_t table;                 // Offset of the object offset table
+    plist_node_t** objects;         // Decoded objects, NULL until first reference
+    uint8_t* busy;                  // Object is being decoded, a reference back is a cycle
+    plist_t* plist;
+    uint32_t depth;
+} bplist_parser_t;
+
+// Count of a variable-length object, 0xf in the marker means an integer object follows
+static int bplist_length(bplist_parser_t* parser, uint64_t* offset, uint8_t low, uint64_t* length) {
+    if (low != 0xf) {
+        *length = low;
+        return 1;
+    }
+    
+    if (*offset >= parser->table) return 0;
+    uint8_t marker = parser->data[(*offset)++];
+    if ((marker & 0xf0) != 0x10 || (marker & 0x0f) > 3) return 0;
+    
+    uint32_t bytes = 1u << (marker & 0x0f);
+    if (parser->table - *offset < bytes) return 0;
+    *length = read_be(parser->data + *offset, bytes);
+    *offset += bytes;
+    return 1;
+}
+
+// Objects end before the offset table, every length is checked against it
+static plist_node_t* bplist_scalar(bplist_parser_t* parser, uint64_t offset) {
+    plist_t* plist = parser->plist;
+    uint8_t marker = parser->data[offset++];
+    uint8_t low = marker & 0x0f;
+    uint64_t avail = parser->table - offset;
+    plist_node_t* node = NULL;
+    
+    switch (marker >> 4) {
+        case 0x0:
+            if (marker != 0x08 && marker != 0x09) return NULL;
+            node = new_node(plist, PLIST_BOOL);
+            if (node) node->integer = marker == 0x09;
+            return node;
+        
+        case 0x1: {
+            // 16-byte integers keep their low 64 bits
+            if (low > 4 || avail < (1u << low)) return NULL;
+            uint32_t bytes = 1u << low;
+            node = new_node(plist, PLIST_INTEGER);
+            if (node) node->integer = (int64_t)read_be(parser->data + offset + (bytes > 8 ? bytes - 8 : 0), bytes > 8 ? 8 : bytes);
+            return node;
+        }
+        
+        case 0x2:
+        case 0x3: {
+            if (marker == 0x33) low = 3;
+            else if ((marker >> 4) == 0x3 || (low != 2 && low != 3)) return NULL;
+            if (avail < (1u << low)) return NULL;
+            node = new_node(plist, marker == 0x33 ? PLIST_DATE : PLIST_REAL);
+            if (!node) return NULL;
+            if (low == 2) {
+                uint32_t bits = (uint32_t)read_be(parser->data + offset, 4);
+                float value;
+                memcpy(&value, &bits, sizeof(value));
+                node->real = value;
+            } else {
+                uint64_t bits = read_be(parser->data + offset, 8);
+                memcpy(&node->real, &bits, sizeof(node->real));
+            }
+            return node;
+        }
+        
+        case 0x4: {
+            uint64_t length;
+            if (!bplist_length(parser, &offset, low, &length) || length > parser->table - offset) return NULL;
+            node = new_node(plist, PLIST_DATA);
+            if (!node) return NULL;
+            node->data = parser->data + offset;
+            node->length = (uint32_t)length;
+            return node;
+        }
+        
+        case 0x5:
+        case 0x6: {
+            // ASCII is copied, UTF-16BE is converted to UTF-8, both NUL terminated
+            int utf16 = (marker >> 4) == 0x6;
+            uint64_t length;
+            if (!bplist_length(parser, &offset, low, &length)) return NULL;
+            if (length > (parser->table - offset) >> (utf16 ? 1 : 0)) return NULL;
+            
+            node = new_node(plist, PLIST_STRING);
+            char* text = node ? arena_alloc(plist, utf16 ? length * 3 + 1 : length + 1) : NULL;
+            if (!text) return NULL;
+            
+            const uint8_t* p = parser->data + offset;
+            size_t n = 0;
+            if (!utf16) {
+                memcpy(text, p, (size_t)length);
+                n = (size_t)length;
+            } else {
+                for (uint64_t i = 0; i < length; i++) {
+                    uint32_t cp = ((uint32_t)p[i * 2] << 8) | p[i * 2 + 1];
+                    if (cp >= 0xd800 && cp < 0xdc00 && i + 1 < length) {
+                        uint32_t low_unit = ((uint32_t)p[i * 2 + 2] << 8) | p[i * 2 + 3];
+                        if (low_unit >= 0xdc00 && low_unit < 0xe000) {
+                            cp = 0x10000 + ((cp - 0xd800) << 10) + (low_unit - 0xdc00);
+                            i++;
+                        }
+                    }
+                    n += (size_t)utf8_encode(cp, text + n);
+                }
+            }
+            text[n] = '\0';
+            node->string = text;
+            node->length = (uint32_t)n;
+            return node;
+        }
+        
+        default:
+            // UIDs and sets do not appear in property lists we read
+            return NULL;
+    }
+}
+
+// Decode an object the first time it is referenced, arrays and dictionaries are read
+// here so every member reference goes back through the memo and the cycle check
+static plist_node_t* bplist_object(bplist_parser_t* parser, uint64_t ref) {
+    if (ref >= parser->nobjects) return NULL;
+    if (parser->objects[ref]) return parser->objects[ref];
+    if (parser->busy[ref] || parser->depth >= PLIST_MAX_DEPTH) return NULL;
+    
+    uint64_t offset = read_be(parser->data + parser->table + ref * parser->offset_size, parser->offset_size);
+    if (offset < 8 || offset >= parser->table) return NULL;
+    
+    uint8_t marker = parser->data[offset];
+    int is_dict = (marker >> 4) == 0xd;
+    if (!is_dict && (marker >> 4) != 0xa) {
+        parser->objects[ref] = bplist_scalar(parser, offset);
+        return parser->objects[ref];
+    }
+    
+    plist_t* plist = parser->plist;
+    uint64_t count;
+    offset++;
+    if (!bplist_length(parser, &offset, marker & 0x0f, &count)) return NULL;
+    uint64_t refs = is_dict ? count * 2 : count;
+    if (count > UINT32_MAX || refs > (parser->table - offset) / parser->ref_size) return NULL;
+    
+    plist_node_t* node = new_node(plist, is_dict ? PLIST_DICT : PLIST_ARRAY);
+    if (!node) return NULL;
+    node->count = (uint32_t)count;
+    node->items = count ? arena_alloc(plist, (size_t)count * sizeof(plist_node_t*)) : NULL;
+    if (is_dict) {
+        node->keys = count ? arena_alloc(plist, (size_t)count * sizeof(char*)) : NULL;
+    }
+    if (count && (!node->items || (is_dict && !node->keys))) return NULL;
+    
+    // Dictionaries list every key reference, then every value reference
+    parser->busy[ref] = 1;
+    parser->depth++;
+    const uint8_t* p = parser->data + offset;
+    for (uint64_t i = 0; i < count; i++) {
+        if (is_dict) {
+            plist_node_t* key = bplist_object(parser, read_be(p + i * parser->ref_size, parser->ref_size));
+            if (!key || key->type != PLIST_STRING) return NULL;
+            node->keys[i] = key->string;
+        }
+        uint64_t value_ref = read_be(p + (is_dict ? count + i : i) * parser->ref_size, parser->ref_size);
+        node->items[i] = bplist_object(parser, value_ref);
+        if (!node->items[i]) return NULL;
+    }
+    parser->depth--;
+    parser->busy[ref] = 0;
+    
+    parser->objects[ref] = node;
+    return node;
+}
+
+static macho_error_t parse_bplist(const uint8_t* data, size_t size, plist_t* plist) {
+    bplist_parser_t parser;
+    memset(&parser, 0, sizeof(parser));
+    parser.data = data;
+    parser.size = size;
+    parser.plist = plist;
+    
+    // Trailer: 6 unused bytes, offset and reference sizes, then three 64-bit counts
+    const uint8_t* trailer = data + size - 32;
+    parser.offset_size = trailer[6];
+    parser.ref_size = trailer[7];
+    parser.nobjects = read_be(trailer + 8, 8);
+    uint64_t top = read_be(trailer + 16, 8);
+    parser.table = read_be(trailer + 24, 8);
+    
+    if (parser.offset_size == 0 || parser.offset_size > 8 || parser.ref_size == 0 || parser.ref_size > 8) return ERROR_READ_FAILED;
+    if (parser.table < 9 || parser.table > size - 32) return ERROR_READ_FAILED;
+    if (parser.nobjects == 0 || parser.nobjects > (size - 32 - parser.table) / parser.offset_size) return ERROR_READ_FAILED;
+    if (top >= parser.nobjects) return ERROR_READ_FAILED;
+    
+    // One node per object and one pointer per reference. ASCII strings take their
+    // length plus a NUL, UTF-16 grows by at most half in UTF-8.
+    size_t nobjects = (size_t)parser.nobjects;
+    size_t refs = (size_t)parser.table / parser.ref_size + 1;
+    if (!arena_init(plist, nobjects * (sizeof(plist_node_t) + sizeof(void*) + 2 + 3 * ARENA_ALIGN) +
+                           refs * sizeof(void*) + (size_t)parser.table * 3 / 2 + 64)) {
+        return ERROR_READ_FAILED;
+    }
+    
+    parser.objects = arena_alloc(plist, (size_t)parser.nobjects * sizeof(plist_node_t*));
+    parser.busy = arena_alloc(plist, (size_t)parser.nobjects);
+    if (!parser.objects || !parser.busy) return ERROR_READ_FAILED;
+    memset(parser.objects, 0, (size_t)parser.nobjects * sizeof(plist_node_t*));
+    memset(parser.busy, 0, (size_t)parser.nobjects);
+    
+    // Only objects reachable from the top object are ever decoded
+    plist->root = bplist_object(&parser, top);
+    return plist->root ? SUCCESS : ERROR_READ_FAILED;
+}
+
+// DER tags of the CoreEntitlements encoding
+#define DER_BOOLEAN         0x01
+#define DER_INTEGER         0x02
+#define DER_UTF8_STRING     0x0c
+#define DER_SEQUENCE        0x30    // Array, or a key/value pair inside a dictionary
+#define DER_SET             0x31    // Dictionary
+#define DER_ENTITLEMENTS    0x70    // [APPLICATION 16], version then the dictionary
+#define DER_DICTIONARY      0xb0    // [CONTEXT 16]
+
+// DER entitlements state, one forward pass with nodes built as each TLV is read
+typedef struct {
+    const uint8_t* p;
+    const uint8_t* end;
+    plist_t* plist;
+    uint32_t depth;
+} der_parser_t;
+
+// Tag and definite length, the content must fit in the enclosing element
+static int der_header(der_parser_t* parser, uint8_t* tag, const uint8_t** content, size_t* length) {
+    if (parser->end - parser->p < 2) return 0;
+    
+    *tag = parser->p[0];
+    uint8_t first = parser->p[1];
+    parser->p += 2;
+    
+    // High tag numbers never appear in entitlements
+    if ((*tag & 0x1f) == 0x1f) return 0;
+    
+    size_t value = first;
+    if (first & 0x80) {
+        // Long form, 0x80 alone is the indefinite length BER allows and DER does not
+        uint32_t n = first & 0x7f;
+        if (n == 0 || n > 4 || (size_t)(parser->end - parser->p) < n) return 0;
+        value = (size_t)read_be(parser->p, n);
+        parser->p += n;
+    }
+    if (value > (size_t)(parser->end - parser->p)) return 0;
+    
+    *content = parser->p;
+    *length = value;
+    parser->p += value;
+    return 1;
+}
+
+// Narrow the parser to a constructed element's content, the caller restores saved_end
+static int der_enter(der_parser_t* parser, const uint8_t* content, size_t length, const uint8_t** saved_end) {
+    if (++parser->depth > PLIST_MAX_DEPTH) return 0;
+    
+    *saved_end = parser->end;
+    parser->p = content;
+    parser->end = content + length;
+    return 1;
+}
+
+// UTF8String copied out with a NUL so keys and values read like the other formats
+static char* der_string(plist_t* plist, const uint8_t* content, size_t length) {
+    char* text = arena_alloc(plist, length + 1);
+    if (!text) return NULL;
+    
+    memcpy(text, content, length);
+    text[length] = '\0';
+    return text;
+}
+
+// BOOLEAN, INTEGER and UTF8String, anything else is refused
+static plist_node_t* der_scalar(plist_t* plist, uint8_t tag, const uint8_t* content, size_t length) {
+    plist_node_t* node;
+    switch (tag) {
+        case DER_BOOLEAN:
+            if (length != 1 || !(node = new_node(plist, PLIST_BOOL))) return NULL;
+            node->integer = content[0] != 0;
+            return node;
+        case DER_INTEGER: {
+            // Two's complement, big-endian, sign extended from the first byte. Leading
+            // bytes that only repeat the sign are dropped, anything else over 64 bits is refused.
+            if (length == 0 || !(node = new_node(plist, PLIST_INTEGER))) return NULL;
+            uint8_t fill = (content[0] & 0x80) ? 0xff : 0x00;
+            while (length > 8 && content[0] == fill) {
+                content++;
+                length--;
+            }
+            if (length > 8 || (length == 8 && (content[0] & 0x80) != (fill & 0x80))) return NULL;
+            uint64_t value = fill ? ~(uint64_t)0 : 0;
+            for (size_t i = 0; i < length; i++) {
+                value = (value << 8) | content[i];
+            }
+            node->integer = (int64_t)value;
+            return node;
+        }
+        case DER_UTF8_STRING:
+            if (!(node = new_node(plist, PLIST_STRING))) return NULL;
+            node->string = der_string(plist, content, length);
+            node->length = (uint32_t)length;
+            return node->string ? node : NULL;
+        default:
+            return NULL;
+    }
+}
+
+// A SEQUENCE is an array, a SET is a dictionary of SEQUENCE { UTF8String key, value }
+static plist_node_t* der_value(der_parser_t* parser) {
+    plist_t* plist = parser->plist;
+    uint8_t tag;
+    const uint8_t* content;
+    size_t length;
+    if (!der_header(parser, &tag, &content, &length)) return NULL;
+    if (tag != DER_SEQUENCE && tag != DER_SET) return der_scalar(plist, tag, content, length);
+    
+    int is_dict = tag == DER_SET;
+    plist_node_t* node = new_node(plist, is_dict ? PLIST_DICT : PLIST_ARRAY);
+    const uint8_t* saved_end;
+    if (!node || !der_enter(parser, content, length, &saved_end)) return NULL;
+    
+    size_t mark = plist->top;
+    while (parser->p < parser->end) {
+        if (is_dict) {
+            const uint8_t* pair;
+            size_t pair_length;
+            const uint8_t* pair_end;
+            if (!der_header(parser, &tag, &pair, &pair_length) || tag != DER_SEQUENCE) return NULL;
+            if (!der_enter(parser, pair, pair_length, &pair_end)) return NULL;
+            
+            const uint8_t* key;
+            size_t key_length;
+            if (!der_header(parser, &tag, &key, &key_length) || tag != DER_UTF8_STRING) return NULL;
+            char* text = der_string(plist, key, key_length);
+            plist_node_t* value = der_value(parser);
+            if (!text || !value || parser->p != parser->end) return NULL;
+            if (!scratch_push(plist, text) || !scratch_push(plist, value)) return NULL;
+            
+            parser->end = pair_end;
+            parser->depth--;
+        } else {
+            plist_node_t* value = der_value(parser);
+            if (!value || !scratch_push(plist, value)) return NULL;
+        }
+    }
+    
+    parser->end = saved_end;
+    parser->depth--;
+    return collect_items(plist, node, mark, is_dict) ? node : NULL;
+}
+
+// Parse a DER entitlements payload (code signature slot 7) into the property list model
+macho_error_t plist_parse_der(const void* data, size_t size, plist_t* plist) {
+    if (!data || !plist) return ERROR_READ_FAILED;
+    
+    memset(plist, 0, sizeof(*plist));
+    der_parser_t parser = { data, (const uint8_t*)data + size, plist, 0 };
+    
+    // Every TLV takes at least two bytes, so size / 2 bounds the nodes the way '<' does for XML
+    size_t nodes = size / 2 + 1;
+    macho_error_t err = ERROR_READ_FAILED;
+    if (!arena_init(plist, nodes * (sizeof(plist_node_t) + 4 * sizeof(void*) + 1 + 3 * ARENA_ALIGN) + size + 64)) {
+        return err;
+    }
+    
+    uint8_t tag;
+    const uint8_t* content;
+    size_t length;
+    const uint8_t* outer_end;
+    const uint8_t* version;
+    size_t version_length;
+    if (der_header(&parser, &tag, &content, &length) && tag == DER_ENTITLEMENTS &&
+        der_enter(&parser, content, length, &outer_end) &&
+        der_header(&parser, &tag, &version, &version_length) && tag == DER_INTEGER &&
+        version_length == 1 && version[0] == 1 &&
+        der_header(&parser, &tag, &content, &length) && tag == DER_DICTIONARY &&
+        der_enter(&parser, content, length, &outer_end)) {
+        // The context element holds exactly one value, the entitlements dictionary
+        plist->root = der_value(&parser);
+        if (plist->root && parser.p == parser.end) err = SUCCESS;
+    }
+    
+    if (err != SUCCESS) {
+        plist_free(plist);
+    }
+    return err;
+}
+
+// Parse an XML or binary (bplist00) property list into one arena
+macho_error_t plist_parse(const void* data, size_t size, plist_t* plist) {
+    if (!data || !plist) return ERROR_READ_FAILED;
+    
+    memset(plist, 0, sizeof(*plist));
+    int binary = size >= 40 && memcmp(data, "bplist00", 8) == 0;
+    
+    // Each parser sizes the arena from its input so the parse never needs a second block
+    macho_error_t err = binary ? parse_bplist(data, size, plist) : parse_xml(data, size, plist);
+    if (err != SUCCESS) {
+        plist_free(plist);
+    }
+    return err;
+}
+
+// Look up a dictionary member by key
+const plist_node_t* plist_dict_get(const plist_node_t* dict, const char* key) {
+    if (!dict || dict->type != PLIST_DICT || !key) return NULL;
+    
+    for (uint32_t i = 0; i < dict->count; i++) {
+        if (strcmp(dict->keys[i], key) == 0) return dict->items[i];
+    }
+    return NULL;
+}
+
+const char* plist_type_name(plist_type_t type) {
+    switch (type) {
+        case PLIST_STRING: return "string";
+        case PLIST_BOOL: return "bool";
+        case PLIST_INTEGER: return "integer";
+        case PLIST_REAL: return "real";
+        case PLIST_DATE: return "date";
+        case PLIST_DATA: return "data";
+        case PLIST_ARRAY: return "array";
+        case PLIST_DICT: return "dict";
+        default: return "unknown";
+    }
+
+}
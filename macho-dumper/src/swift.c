@@ -15,9 +15,10 @@ macho_error_t find_swift_metadata(const macho_ctx_t* ctx, swift_metadata_t* meta
     
     memset(metadata, 0, sizeof(swift_metadata_t));
     
-    segment_info_t* segments = NULL;
+    // Segment model is cached on the context, not owned here
+    const segment_info_t* segments = NULL;
     uint32_t nsegments = 0;
-    macho_error_t err = parse_segment_commands(ctx, &segments, &nsegments);
+    macho_error_t err = get_segments(ctx, &segments, &nsegments);
     if (err != SUCCESS) {
         return err;
     }
@@ -57,8 +58,6 @@ macho_error_t find_swift_metadata(const macho_ctx_t* ctx, swift_metadata_t* meta
         }
     }
     
-    free_segments(segments, nsegments);
-    
     if (!found_swift) {
         return ERROR_INVALID_SWIFT_DATA;
     }
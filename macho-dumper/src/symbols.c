@@ -0,0 +1,371 @@
+/*
+* symbols.c
+* Coded by iosmen (c) 2025
+*/
+#include "../include/macho.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint64_t address;
+    uint32_t entry;
+} symbol_sort_t;
+
+static int compare_symbols(const void* a, const void* b) {
+    const symbol_sort_t* sa = (const symbol_sort_t*)a;
+    const symbol_sort_t* sb = (const symbol_sort_t*)b;
+    if (sa->address != sb->address) return sa->address < sb->address ? -1 : 1;
+    
+    // Symbol table order among aliases keeps results deterministic
+    return sa->entry < sb->entry ? -1 : (sa->entry > sb->entry);
+}
+
+// FNV-1a over a name, seeded so a leading '_' can be hashed without copying the name
+static uint32_t hash_symbol_name(uint32_t hash, const char* name, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+#define SYMBOL_HASH_SEED 2166136261u
+
+// Hash every name in place: slots hold symbol numbers, names stay (strx, length) pairs
+// in the string table, so nothing is copied
+static macho_error_t build_name_table(symbol_index_t* index) {
+    // Keep the load factor at or below one half
+    uint32_t table_size = 8;
+    while (table_size < index->count * 2) {
+        table_size <<= 1;
+    }
+    
+    index->name_table = calloc(table_size, sizeof(uint32_t));
+    if (!index->name_table) return ERROR_READ_FAILED;
+    index->name_table_size = table_size;
+    
+    for (uint32_t i = 0; i < index->count; i++) {
+        uint32_t len = index->name_lengths[i];
+        if (len == 0) continue;
+        
+        const char* name = index->strtab + index->strx[i];
+        uint32_t slot = hash_symbol_name(SYMBOL_HASH_SEED, name, len) & (table_size - 1);
+        
+        // Lowest address wins when a name is defined more than once
+        while (index->name_table[slot]) {
+            uint32_t other = index->name_table[slot] - 1;
+            if (index->name_lengths[other] == len &&
+                memcmp(index->strtab + index->strx[other], name, len) == 0) {
+                break;
+            }
+            slot = (slot + 1) & (table_size - 1);
+        }
+        if (!index->name_table[slot]) {
+            index->name_table[slot] = i + 1;
+        }
+    }
+    
+    return SUCCESS;
+}
+
+// Build the index straight from the nlist entries in the image
+macho_error_t build_symbol_index(const macho_ctx_t* ctx, symbol_index_t* index) {
+    if (!ctx || !index) return ERROR_READ_FAILED;
+    memset(index, 0, sizeof(symbol_index_t));
+    
+    const load_command_t* lc = ctx->lc_index.symtab;
+    if (!lc) return ERROR_INVALID_SECTION;
+    
+    const struct symtab_command* symtab = (const struct symtab_command*)lc->data;
+    uint32_t symoff = ctx->is_swap ? swap32(symtab->symoff) : symtab->symoff;
+    uint32_t nsyms = ctx->is_swap ? swap32(symtab->nsyms) : symtab->nsyms;
+    uint32_t stroff = ctx->is_swap ? swap32(symtab->stroff) : symtab->stroff;
+    uint32_t strsize = ctx->is_swap ? swap32(symtab->strsize) : symtab->strsize;
+    
+    size_t entry_size = ctx->is_64bit ? sizeof(struct nlist_64) : sizeof(struct nlist);
+    if (symoff > ctx->size || nsyms > (ctx->size - symoff) / entry_size ||
+        stroff > ctx->size || strsize > ctx->size - stroff) {
+        return ERROR_INVALID_SECTION;
+    }
+    
+    index->strtab = (const char*)ctx->data + stroff;
+    index->nsyms = nsyms;
+    
+    // A name running off the end of the table is treated as empty
+    while (strsize > 0 && index->strtab[strsize - 1] != '\0') {
+        strsize--;
+    }
+    index->strsize = strsize;
+    
+    const uint8_t* syms = (const uint8_t*)ctx->data + symoff;
+    symbol_sort_t* order = malloc((nsyms ? nsyms : 1) * sizeof(symbol_sort_t));
+    if (!order) return ERROR_READ_FAILED;
+    
+    // Defined symbols only: they are the ones with an address
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < nsyms; i++) {
+        uint8_t n_type;
+        uint64_t n_value;
+        if (ctx->is_64bit) {
+            const struct nlist_64* sym = (const struct nlist_64*)(syms + i * entry_size);
+            n_type = sym->n_type;
+            n_value = ctx->is_swap ? swap64(sym->n_value) : sym->n_value;
+        } else {
+            const struct nlist* sym = (const struct nlist*)(syms + i * entry_size);
+            n_type = sym->n_type;
+            n_value = ctx->is_swap ? swap32(sym->n_value) : sym->n_value;
+        }
+        if ((n_type & N_STAB) || (n_type & N_TYPE) != N_SECT) continue;
+        
+        order[count].address = n_value;
+        order[count].entry = i;
+        count++;
+    }
+    
+    qsort(order, count, sizeof(symbol_sort_t), compare_symbols);
+    
+    // One allocation for every column
+    size_t alloc = count ? count : 1;
+    uint8_t* block = malloc(alloc * (sizeof(uint64_t) + 2 * sizeof(uint32_t) + sizeof(uint16_t) + 2));
+    if (!block) {
+        free(order);
+        return ERROR_READ_FAILED;
+    }
+    index->addresses = (uint64_t*)block;
+    index->strx = (uint32_t*)(index->addresses + alloc);
+    index->name_lengths = index->strx + alloc;
+    index->descs = (uint16_t*)(index->name_lengths + alloc);
+    index->types = (uint8_t*)(index->descs + alloc);
+    index->sects = index->types + alloc;
+    
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t* entry = syms + (size_t)order[i].entry * entry_size;
+        uint32_t n_strx;
+        uint16_t n_desc;
+        if (ctx->is_64bit) {
+            const struct nlist_64* sym = (const struct nlist_64*)entry;
+            n_strx = sym->n_un.n_strx;
+            n_desc = sym->n_desc;
+            index->types[i] = sym->n_type;
+            index->sects[i] = sym->n_sect;
+        } else {
+            const struct nlist* sym = (const struct nlist*)entry;
+            n_strx = sym->n_un.n_strx;
+            n_desc = (uint16_t)sym->n_desc;
+            index->types[i] = sym->n_type;
+            index->sects[i] = sym->n_sect;
+        }
+        if (ctx->is_swap) {
+            n_strx = swap32(n_strx);
+            n_desc = (uint16_t)((n_desc >> 8) | (n_desc << 8));
+        }
+        
+        index->addresses[i] = order[i].address;
+        // Names outside the table are empty, the rest are bounded by its end
+        index->strx[i] = n_strx < strsize ? n_strx : 0;
+        index->name_lengths[i] = n_strx < strsize ? (uint32_t)strnlen(index->strtab + n_strx, strsize - n_strx) : 0;
+        index->descs[i] = n_desc;
+    }
+    index->count = count;
+    
+    free(order);
+    return build_name_table(index);
+}
+
+void free_symbol_index(symbol_index_t* index) {
+    if (!index) return;
+    
+    // Columns share the addresses allocation
+    free(index->addresses);
+    free(index->name_table);
+    memset(index, 0, sizeof(symbol_index_t));
+}
+
+// Lazily built index cached on the context
+macho_error_t get_symbol_index(const macho_ctx_t* ctx, const symbol_index_t** index) {
+    if (!ctx || !ctx->cache || !index) return ERROR_READ_FAILED;
+    
+    macho_cache_t* cache = ctx->cache;
+    pthread_mutex_lock(&cache->lock);
+    if (!cache->symbols_built) {
+        cache->symbols_err = build_symbol_index(ctx, &cache->symbols);
+        cache->symbols_built = 1;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    
+    *index = &cache->symbols;
+    return cache->symbols_err;
+}
+
+const char* symbol_name(const symbol_index_t* index, uint32_t i) {
+    if (!index || i >= index->count || !index->strtab || index->name_lengths[i] == 0) return "";
+    return index->strtab + index->strx[i];
+}
+
+// First symbol whose address is >= address, count if there is none
+uint32_t symbol_lower_bound(const symbol_index_t* index, uint64_t address) {
+    if (!index) return 0;
+    
+    uint32_t lo = 0, hi = index->count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (index->addresses[mid] < address) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Closest symbol at or below address (first alias when several share it). The address
+// must fall inside that symbol's section, past it the symbol says nothing about it.
+int find_symbol_by_address(const macho_ctx_t* ctx, const symbol_index_t* index, uint64_t address, uint32_t* i) {
+    if (!index || !i || index->count == 0) return 0;
+    
+    uint32_t pos = symbol_lower_bound(index, address);
+    if (pos < index->count && index->addresses[pos] == address) {
+        *i = pos;
+        return 1;
+    }
+    if (pos == 0) return 0;
+    
+    pos = symbol_lower_bound(index, index->addresses[pos - 1]);
+    const section_info_t* sect = section_for_ordinal(ctx, index->sects[pos]);
+    if (!sect || address < sect->addr || address - sect->addr >= sect->size) return 0;
+    
+    *i = pos;
+    return 1;
+}
+
+// Probe the name table for prefix (0 or 1 underscore) followed by name
+static int lookup_name(const symbol_index_t* index, int underscore, const char* name, size_t len, uint32_t* i) {
+    uint32_t hash = underscore ? hash_symbol_name(SYMBOL_HASH_SEED, "_", 1) : SYMBOL_HASH_SEED;
+    uint32_t mask = index->name_table_size - 1;
+    uint32_t slot = hash_symbol_name(hash, name, len) & mask;
+    
+    while (index->name_table[slot]) {
+        uint32_t j = index->name_table[slot] - 1;
+        const char* sym = index->strtab + index->strx[j];
+        if (index->name_lengths[j] == len + (size_t)underscore &&
+            (!underscore || sym[0] == '_') && memcmp(sym + underscore, name, len) == 0) {
+            *i = j;
+            return 1;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return 0;
+}
+
+// Match a name exactly, or else with a leading underscore added
+int find_symbol_by_name_len(const symbol_index_t* index, const char* name, size_t len, uint32_t* i) {
+    if (!index || !index->name_table || !name || len == 0 || !i) return 0;
+    
+    return lookup_name(index, 0, name, len, i) || lookup_name(index, 1, name, len, i);
+}
+
+int find_symbol_by_name(const symbol_index_t* index, const char* name, uint32_t* i) {
+    if (!name) return 0;
+    return find_symbol_by_name_len(index, name, strlen(name), i);
+}
+
+// Section of a 1-based n_sect ordinal, counted across segments in load command order
+const section_info_t* section_for_ordinal(const macho_ctx_t* ctx, uint8_t ordinal) {
+    const segment_info_t* segments = NULL;
+    uint32_t nsegments = 0;
+    if (ordinal == NO_SECT || get_segments(ctx, &segments, &nsegments) != SUCCESS) return NULL;
+    
+    uint32_t remaining = ordinal - 1;
+    for (uint32_t i = 0; i < nsegments; i++) {
+        if (remaining < segments[i].nsects) {
+            return &segments[i].sections[remaining];
+        }
+        remaining -= segments[i].nsects;
+    }
+    return NULL;
+}
+
+// Look up names through the hash index and print address, section and flags of each
+void print_symbol_lookups(output_t* out, const macho_ctx_t* ctx, char* const* names, uint32_t count) {
+    const symbol_index_t* index = NULL;
+    if (get_symbol_index(ctx, &index) != SUCCESS) {
+        output_str(out, "symbols_error", "Error", "No symbol table found");
+        return;
+    }
+    
+    output_begin_array(out, "symbol_lookups", "Symbols", count);
+    for (uint32_t i = 0; i < count; i++) {
+        output_begin_inline(out, "symbol", names[i]);
+        output_str(out, "name", NULL, names[i]);
+        
+        uint32_t sym;
+        if (!find_symbol_by_name(index, names[i], &sym)) {
+            output_str(out, "error", "", "not found");
+            output_end_object(out);
+            continue;
+        }
+        
+        char section[40] = "";
+        const section_info_t* sect = section_for_ordinal(ctx, index->sects[sym]);
+        if (sect) {
+            snprintf(section, sizeof(section), "%.16s,%.16s", sect->segname, sect->sectname);
+        }
+        
+        uint8_t type = index->types[sym];
+        uint16_t desc = index->descs[sym];
+        char flags[64];
+        snprintf(flags, sizeof(flags), "%s%s%s%s",
+                 (type & N_PEXT) ? "private_extern" : (type & N_EXT) ? "external" : "local",
+                 (desc & N_WEAK_DEF) ? " weak_def" : "",
+                 (desc & N_ARM_THUMB_DEF) ? " thumb" : "",
+                 (desc & N_NO_DEAD_STRIP) ? " no_dead_strip" : "");
+        
+        output_str(out, "symbol", NULL, symbol_name(index, sym));
+        output_hex(out, "address", "address", index->addresses[sym]);
+        output_str(out, "section", "section", section);
+        output_uint(out, "sect", NULL, index->sects[sym]);
+        output_str(out, "flags", "flags", flags);
+        output_hex(out, "n_type", NULL, type);
+        output_hex(out, "n_desc", NULL, desc);
+        output_end_object(out);
+    }
+    output_end_array(out);
+}
+
+// Symbolicate addresses as name+offset, e.g. frames of a crash log
+void print_address_symbols(output_t* out, const macho_ctx_t* ctx, const uint64_t* addresses, uint32_t count) {
+    const symbol_index_t* index = NULL;
+    if (get_symbol_index(ctx, &index) != SUCCESS) {
+        output_str(out, "symbols_error", "Error", "No symbol table found");
+        return;
+    }
+    
+    output_begin_array(out, "addresses", "Addresses", count);
+    for (uint32_t i = 0; i < count; i++) {
+        char label[24];
+        snprintf(label, sizeof(label), "0x%llx", (unsigned long long)addresses[i]);
+        output_begin_inline(out, "address", label);
+        output_hex(out, "address", NULL, addresses[i]);
+        
+        // Text shows name+offset like atos, machine formats get the parts as well
+        uint32_t sym;
+        if (find_symbol_by_address(ctx, index, addresses[i], &sym)) {
+            const char* name = symbol_name(index, sym);
+            uint64_t offset = addresses[i] - index->addresses[sym];
+            size_t len = strlen(name) + 24;
+            char* location = malloc(len);
+            if (location) {
+                snprintf(location, len, "%s+0x%llx", name, (unsigned long long)offset);
+                output_str(out, "location", "", location);
+                free(location);
+            }
+            output_str(out, "symbol", NULL, name);
+            output_hex(out, "offset", NULL, offset);
+            output_uint(out, "sect", NULL, index->sects[sym]);
+        } else {
+            output_str(out, "location", "", "???");
+        }
+        output_end_object(out);
+    }
+    output_end_array(out);
+
+}
@@ -0,0 +1,288 @@
+/*
+* threadpool.c
+* Coded by iosmen (c) 2025
+*/
+#include "../include/threadpool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+typedef struct {
+    pool_task_fn fn;
+    void* arg;
+} pool_task_t;
+
+// Ring buffer deque: the owner pushes and pops at the bottom, thieves take from the top
+typedef struct {
+    pthread_mutex_t lock;
+    pool_task_t* tasks;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t count;
+} task_deque_t;
+
+typedef struct {
+    thread_pool_t* pool;
+    uint32_t id;
+} pool_worker_t;
+
+struct thread_pool {
+    pthread_t* threads;
+    pool_worker_t* workers;
+    task_deque_t* deques;
+    uint32_t nthreads;
+    uint32_t started;
+    
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;       // Tasks available or shutdown
+    pthread_cond_t space_cond;      // Queue dropped below max_pending
+    pthread_cond_t idle_cond;       // Nothing queued or running
+    uint32_t pending;
+    uint32_t active;
+    uint32_t max_pending;
+    uint32_t next_deque;
+    int shutdown;
+    
+    pthread_key_t worker_key;
+};
+
+// Push a task at the bottom, growing the ring when full
+static int deque_push(task_deque_t* dq, pool_task_t task) {
+    pthread_mutex_lock(&dq->lock);
+    if (dq->count == dq->capacity) {
+        uint32_t capacity = dq->capacity ? dq->capacity * 2 : 16;
+        pool_task_t* tasks = malloc(capacity * sizeof(pool_task_t));
+        if (!tasks) {
+            pthread_mutex_unlock(&dq->lock);
+            return 0;
+        }
+        for (uint32_t i = 0; i < dq->count; i++) {
+            tasks[i] = dq->tasks[(dq->head + i) % dq->capacity];
+        }
+        free(dq->tasks);
+        dq->tasks = tasks;
+        dq->capacity = capacity;
+        dq->head = 0;
+    }
+    dq->tasks[(dq->head + dq->count) % dq->capacity] = task;
+    dq->count++;
+    pthread_mutex_unlock(&dq->lock);
+    return 1;
+}
+
+// Owner side: newest task first, keeps recently touched data hot
+static int deque_pop(task_deque_t* dq, pool_task_t* task) {
+    int found = 0;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->count > 0) {
+        dq->count--;
+        *task = dq->tasks[(dq->head + dq->count) % dq->capacity];
+        found = 1;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return found;
+}
+
+// Thief side: oldest task first
+static int deque_steal(task_deque_t* dq, pool_task_t* task) {
+    int found = 0;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->count > 0) {
+        *task = dq->tasks[dq->head];
+        dq->head = (dq->head + 1) % dq->capacity;
+        dq->count--;
+        found = 1;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return found;
+}
+
+// Take from our own deque, then steal round-robin from the others
+static int find_task(thread_pool_t* pool, uint32_t id, pool_task_t* task) {
+    if (deque_pop(&pool->deques[id], task)) return 1;
+    
+    for (uint32_t i = 1; i < pool->nthreads; i++) {
+        if (deque_steal(&pool->deques[(id + i) % pool->nthreads], task)) return 1;
+    }
+    return 0;
+}
+
+static void* worker_main(void* arg) {
+    pool_worker_t* worker = (pool_worker_t*)arg;
+    thread_pool_t* pool = worker->pool;
+    pthread_setspecific(pool->worker_key, worker);
+    
+    for (;;) {
+        pool_task_t task;
+        if (find_task(pool, worker->id, &task)) {
+            pthread_mutex_lock(&pool->lock);
+            pool->pending--;
+            pool->active++;
+            pthread_cond_signal(&pool->space_cond);
+            pthread_mutex_unlock(&pool->lock);
+            
+            task.fn(task.arg);
+            
+            pthread_mutex_lock(&pool->lock);
+            pool->active--;
+            if (pool->pending == 0 && pool->active == 0) {
+                pthread_cond_broadcast(&pool->idle_cond);
+            }
+            pthread_mutex_unlock(&pool->lock);
+            continue;
+        }
+        
+        // Queued tasks may still be in flight to a deque, only sleep when none are counted
+        pthread_mutex_lock(&pool->lock);
+        while (pool->pending == 0 && !pool->shutdown) {
+            pthread_cond_wait(&pool->work_cond, &pool->lock);
+        }
+        int done = pool->shutdown && pool->pending == 0;
+        pthread_mutex_unlock(&pool->lock);
+        if (done) break;
+    }
+    
+    return NULL;
+}
+
+// Number of online CPUs, at least one
+uint32_t thread_pool_default_threads(void) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    return ncpu > 0 ? (uint32_t)ncpu : 1;
+}
+
+// Number of workers the pool was created with
+uint32_t thread_pool_size(const thread_pool_t* pool) {
+    return pool ? pool->nthreads : 1;
+}
+
+// Create a pool, 0 threads means one per CPU and 0 max_pending means 4 per thread
+thread_pool_t* thread_pool_create(uint32_t nthreads, uint32_t max_pending) {
+    if (nthreads == 0) nthreads = thread_pool_default_threads();
+    if (max_pending == 0) max_pending = nthreads * 4;
+    
+    thread_pool_t* pool = calloc(1, sizeof(thread_pool_t));
+    if (!pool) return NULL;
+    
+    pool->nthreads = nthreads;
+    pool->max_pending = max_pending;
+    pool->threads = calloc(nthreads, sizeof(pthread_t));
+    pool->workers = calloc(nthreads, sizeof(pool_worker_t));
+    pool->deques = calloc(nthreads, sizeof(task_deque_t));
+    if (!pool->threads || !pool->workers || !pool->deques) {
+        free(pool->threads);
+        free(pool->workers);
+        free(pool->deques);
+        free(pool);
+        return NULL;
+    }
+    
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->space_cond, NULL);
+    pthread_cond_init(&pool->idle_cond, NULL);
+    pthread_key_create(&pool->worker_key, NULL);
+    
+    for (uint32_t i = 0; i < nthreads; i++) {
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+        pool->workers[i].pool = pool;
+        pool->workers[i].id = i;
+    }
+    
+    for (uint32_t i = 0; i < nthreads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, &pool->workers[i]) != 0) {
+            break;
+        }
+        pool->started++;
+    }
+    
+    if (pool->started == 0) {
+        thread_pool_destroy(pool);
+        return NULL;
+    }
+    
+    // Workers that failed to start still own a deque, others steal from it
+    return pool;
+}
+
+// Queue a task. Outside the pool this blocks while max_pending tasks are queued;
+// from a worker the task goes to its own deque, or runs inline when the pool is full.
+macho_error_t thread_pool_submit(thread_pool_t* pool, pool_task_fn fn, void* arg) {
+    if (!pool || !fn) return ERROR_READ_FAILED;
+    
+    pool_worker_t* self = pthread_getspecific(pool->worker_key);
+    if (self && self->pool != pool) self = NULL;
+    
+    pthread_mutex_lock(&pool->lock);
+    if (self) {
+        if (pool->pending >= pool->max_pending) {
+            pthread_mutex_unlock(&pool->lock);
+            fn(arg);
+            return SUCCESS;
+        }
+    } else {
+        while (pool->pending >= pool->max_pending && !pool->shutdown) {
+            pthread_cond_wait(&pool->space_cond, &pool->lock);
+        }
+    }
+    
+    if (pool->shutdown) {
+        pthread_mutex_unlock(&pool->lock);
+        return ERROR_READ_FAILED;
+    }
+    
+    uint32_t target = self ? self->id : pool->next_deque++ % pool->nthreads;
+    pool_task_t task = { fn, arg };
+    if (!deque_push(&pool->deques[target], task)) {
+        pthread_mutex_unlock(&pool->lock);
+        return ERROR_READ_FAILED;
+    }
+    
+    pool->pending++;
+    pthread_cond_signal(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+    return SUCCESS;
+}
+
+// Wait until every submitted task has finished
+void thread_pool_wait(thread_pool_t* pool) {
+    if (!pool) return;
+    
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0 || pool->active > 0) {
+        pthread_cond_wait(&pool->idle_cond, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Finish queued tasks, stop the workers and free the pool
+void thread_pool_destroy(thread_pool_t* pool) {
+    if (!pool) return;
+    
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_cond_broadcast(&pool->space_cond);
+    pthread_mutex_unlock(&pool->lock);
+    
+    for (uint32_t i = 0; i < pool->started; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    
+    for (uint32_t i = 0; i < pool->nthreads; i++) {
+        pthread_mutex_destroy(&pool->deques[i].lock);
+        free(pool->deques[i].tasks);
+    }
+    
+    pthread_key_delete(pool->worker_key);
+    pthread_cond_destroy(&pool->idle_cond);
+    pthread_cond_destroy(&pool->space_cond);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->deques);
+    free(pool->workers);
+    free(pool->threads);
+    free(pool);
+
+}
@@ -6,8 +6,55 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
+#include <sys/stat.h>
 #include "macho.h"
 
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#define EXECUTABLE_PATH_TOKEN "@executable_path"
+#define LOADER_PATH_TOKEN "@loader_path"
+#define RPATH_TOKEN "@rpath/"
+
+// Shared state of one resolution, read-only while a level is loading
+typedef struct {
+    const dependency_options_t* opts;
+    char executable_dir[PATH_MAX];      // Empty when there is no main executable
+    const dylib_node_t* executable;     // Explicit main executable, end of every load chain
+    cpu_type_t cputype;
+    cpu_subtype_t cpusubtype;
+} resolver_t;
+
+// Install name of one load command, resolved on a worker for the merge step
+typedef struct {
+    char* name;
+    char* path;                         // Canonical file, NULL when unresolved
+    int is_stub;
+    uint32_t timestamp;
+    uint32_t current_version;
+    uint32_t compatibility_version;
+} resolved_dylib_t;
+
+// One image of the frontier, parsed and resolved on a worker
+typedef struct {
+    const resolver_t* resolver;
+    dylib_node_t* node;
+    resolved_dylib_t* dylibs;
+    uint32_t ndylibs;
+    macho_error_t err;                  // Out of memory, parse errors go to node->status
+} load_job_t;
+
+// String of a load command at a lc_str offset, NULL when it does not fit the command
+static const char* load_command_string(const load_command_t* lc, uint32_t offset, uint32_t fixed_size) {
+    if (offset < fixed_size || offset >= lc->cmdsize) return NULL;
+    
+    const char* str = (const char*)lc->data + offset;
+    size_t max_len = lc->cmdsize - offset;
+    return strnlen(str, max_len) < max_len ? str : NULL;
+}
+
 // Find dynamic library dependencies
 macho_error_t find_dylib_dependencies(const macho_ctx_t* ctx, char*** dylibs, uint32_t* count) {
     if (!ctx || !dylibs || !count) return ERROR_READ_FAILED;
@@ -15,19 +62,8 @@ macho_error_t find_dylib_dependencies(const macho_ctx_t* ctx, char*** dylibs, ui
     *dylibs = NULL;
     *count = 0;
     
-    // First pass: count dylib commands
-    uint32_t dylib_count = 0;
-    for (uint32_t i = 0; i < ctx->ncmds; i++) {
-        struct load_command* lc = ctx->load_commands[i];
-        if (!lc) continue;
-        
-        uint32_t cmd = ctx->is_swap ? swap32(lc->cmd) : lc->cmd;
-        if (cmd == LC_LOAD_DYLIB || cmd == LC_LOAD_WEAK_DYLIB || 
-            cmd == LC_REEXPORT_DYLIB || cmd == LC_LAZY_LOAD_DYLIB) {
-            dylib_count++;
-        }
-    }
-    
+    // Dylib commands come straight from the load command index
+    uint32_t dylib_count = ctx->lc_index.ndylibs;
     if (dylib_count == 0) {
         return SUCCESS;
     }
@@ -38,118 +74,934 @@ macho_error_t find_dylib_dependencies(const macho_ctx_t* ctx, char*** dylibs, ui
         return ERROR_READ_FAILED;
     }
     
-    // Second pass: extract dylib names
-    uint32_t index = 0;
-    for (uint32_t i = 0; i < ctx->ncmds; i++) {
-        struct load_command* lc = ctx->load_commands[i];
-        if (!lc) continue;
+    // One entry per dylib command so bind ordinal N is always entry N - 1, a malformed name is "?"
+    for (uint32_t i = 0; i < dylib_count; i++) {
+        const load_command_t* lc = &ctx->load_commands[ctx->lc_index.dylibs[i]];
+        const char* name = NULL;
+        if (lc->cmdsize >= sizeof(struct dylib_command)) {
+            const struct dylib_command* dylib_cmd = (const struct dylib_command*)lc->data;
+            uint32_t offset = ctx->is_swap ? swap32(dylib_cmd->dylib.name.offset) : dylib_cmd->dylib.name.offset;
+            name = load_command_string(lc, offset, sizeof(struct dylib_command));
+        }
+        
+        (*dylibs)[i] = strdup(name ? name : "?");
+        if (!(*dylibs)[i]) {
+            for (uint32_t j = 0; j < i; j++) {
+                free((*dylibs)[j]);
+            }
+            free(*dylibs);
+            *dylibs = NULL;
+            return ERROR_READ_FAILED;
+        }
+    }
+    
+    *count = dylib_count;
+    return SUCCESS;
+}
+
+// Library a bind ordinal refers to: 1-based index into the dylib list, or a special ordinal
+const char* get_dylib_ordinal_name(char* const* dylibs, uint32_t count, int32_t ordinal) {
+    switch (ordinal) {
+        case BIND_SPECIAL_DYLIB_SELF: return "this image";
+        case BIND_SPECIAL_DYLIB_MAIN_EXECUTABLE: return "main executable";
+        case BIND_SPECIAL_DYLIB_FLAT_LOOKUP: return "flat lookup";
+        case BIND_SPECIAL_DYLIB_WEAK_LOOKUP: return "weak lookup";
+        default:
+            if (ordinal > 0 && (uint32_t)ordinal <= count) return dylibs[ordinal - 1];
+            return NULL;
+    }
+}
+
+// FNV-1a over a NUL terminated path
+static uint32_t hash_path(const char* path) {
+    uint32_t hash = 2166136261u;
+    for (; *path; path++) {
+        hash ^= (uint8_t)*path;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Cache key of a node: the file it resolved to, or its install name when it did not resolve
+static const char* node_key(const dylib_node_t* node) {
+    return node->path ? node->path : node->name;
+}
+
+static dylib_node_t* find_node(const dylib_graph_t* graph, const char* key) {
+    if (!graph->table) return NULL;
+    
+    uint32_t mask = graph->table_size - 1;
+    for (uint32_t i = hash_path(key) & mask; graph->table[i]; i = (i + 1) & mask) {
+        if (strcmp(node_key(graph->table[i]), key) == 0) return graph->table[i];
+    }
+    return NULL;
+}
+
+static void insert_node(dylib_node_t** table, uint32_t table_size, dylib_node_t* node) {
+    uint32_t mask = table_size - 1;
+    uint32_t i = hash_path(node_key(node)) & mask;
+    while (table[i]) {
+        i = (i + 1) & mask;
+    }
+    table[i] = node;
+}
+
+// Append a node and index it, the cache is kept at most half full
+static dylib_node_t* add_node(dylib_graph_t* graph, const char* name, const char* path) {
+    if (graph->count == graph->cap) {
+        uint32_t cap = graph->cap ? graph->cap * 2 : 16;
+        dylib_node_t** nodes = realloc(graph->nodes, cap * sizeof(dylib_node_t*));
+        if (!nodes) return NULL;
+        graph->nodes = nodes;
+        graph->cap = cap;
+    }
+    
+    if ((graph->count + 1) * 2 > graph->table_size) {
+        uint32_t table_size = graph->table_size ? graph->table_size * 2 : 64;
+        dylib_node_t** table = calloc(table_size, sizeof(dylib_node_t*));
+        if (!table) return NULL;
+        for (uint32_t i = 0; i < graph->count; i++) {
+            insert_node(table, table_size, graph->nodes[i]);
+        }
+        free(graph->table);
+        graph->table = table;
+        graph->table_size = table_size;
+    }
+    
+    dylib_node_t* node = calloc(1, sizeof(dylib_node_t));
+    if (!node) return NULL;
+    node->name = strdup(name);
+    node->path = path ? strdup(path) : NULL;
+    if (!node->name || (path && !node->path)) {
+        free(node->name);
+        free(node->path);
+        free(node);
+        return NULL;
+    }
+    
+    node->id = graph->count;
+    graph->nodes[graph->count++] = node;
+    insert_node(graph->table, graph->table_size, node);
+    return node;
+}
+
+// Directory part of a path, "." when it has none
+static void path_dirname(const char* path, char* dir, size_t size) {
+    const char* slash = strrchr(path, '/');
+    if (!slash) {
+        snprintf(dir, size, ".");
+        return;
+    }
+    
+    size_t len = slash == path ? 1 : (size_t)(slash - path);
+    if (len >= size) len = size - 1;
+    memcpy(dir, path, len);
+    dir[len] = '\0';
+}
+
+static int is_file(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+// Length of a leading path token, alone or followed by a '/', 0 when path does not start with it
+static size_t match_path_token(const char* path, const char* token, size_t len) {
+    return strncmp(path, token, len) == 0 && (path[len] == '/' || path[len] == '\0') ? len : 0;
+}
+
+// Replace a leading @executable_path or @loader_path, 0 when the token cannot be expanded
+static int expand_path_token(const resolver_t* resolver, const dylib_node_t* loader, const char* path,
+                             char* out, size_t size) {
+    char loader_dir[PATH_MAX];
+    const char* dir;
+    size_t len;
+    
+    if ((len = match_path_token(path, EXECUTABLE_PATH_TOKEN, sizeof(EXECUTABLE_PATH_TOKEN) - 1)) != 0) {
+        if (!resolver->executable_dir[0]) return 0;
+        dir = resolver->executable_dir;
+    } else if ((len = match_path_token(path, LOADER_PATH_TOKEN, sizeof(LOADER_PATH_TOKEN) - 1)) != 0) {
+        if (!loader->path) return 0;
+        path_dirname(loader->path, loader_dir, sizeof(loader_dir));
+        dir = loader_dir;
+    } else if (path[0] == '@') {
+        return 0;
+    } else {
+        return snprintf(out, size, "%s", path) < (int)size;
+    }
+    return snprintf(out, size, "%s%s", dir, path + len) < (int)size;
+}
+
+// Find the file behind an expanded path. Absolute paths written in a load command are looked
+// up in the SDK root first, where a .tbd stub stands in for libraries only in the shared cache.
+static int find_candidate(const resolver_t* resolver, const char* path, int rooted, char* out, size_t size,
+                          int* is_stub) {
+    const char* root = resolver->opts ? resolver->opts->sdk_root : NULL;
+    
+    *is_stub = 0;
+    if (root && rooted && path[0] == '/') {
+        if (snprintf(out, size, "%s%s", root, path) < (int)size && is_file(out)) return 1;
         
-        uint32_t cmd = ctx->is_swap ? swap32(lc->cmd) : lc->cmd;
-        if (cmd == LC_LOAD_DYLIB || cmd == LC_LOAD_WEAK_DYLIB || 
-            cmd == LC_REEXPORT_DYLIB || cmd == LC_LAZY_LOAD_DYLIB) {
+        size_t len = strlen(path);
+        const char* ext = strrchr(path, '.');
+        if (ext && ext > strrchr(path, '/') && strcmp(ext, ".dylib") == 0) {
+            len = (size_t)(ext - path);
+        }
+        if (snprintf(out, size, "%s%.*s.tbd", root, (int)len, path) < (int)size && is_file(out)) {
+            *is_stub = 1;
+            return 1;
+        }
+    }
+    return snprintf(out, size, "%s", path) < (int)size && is_file(out);
+}
+
+// Resolve an install name the way dyld does for this loader, 1 when a file was found
+static int resolve_install_name(const resolver_t* resolver, const dylib_node_t* loader, const char* name,
+                                char* out, size_t size, int* is_stub) {
+    char expanded[PATH_MAX];
+    
+    if (strncmp(name, RPATH_TOKEN, sizeof(RPATH_TOKEN) - 1) == 0) {
+        // Every LC_RPATH of the load chain, from the loader up to the main executable.
+        // @loader_path in an rpath is relative to the image that declares it.
+        const char* rest = name + sizeof(RPATH_TOKEN) - 1;
+        const dylib_node_t* image = loader;
+        while (image) {
+            for (uint32_t i = 0; i < image->nrpaths; i++) {
+                const char* rpath = image->rpaths[i];
+                char dir[PATH_MAX];
+                if (!expand_path_token(resolver, image, rpath, dir, sizeof(dir))) continue;
+                if (snprintf(expanded, sizeof(expanded), "%s/%s", dir, rest) >= (int)sizeof(expanded)) continue;
+                if (find_candidate(resolver, expanded, rpath[0] != '@', out, size, is_stub)) return 1;
+            }
+            if (image->loader) {
+                image = image->loader;
+            } else if (image != resolver->executable) {
+                image = resolver->executable;
+            } else {
+                image = NULL;
+            }
+        }
+        return 0;
+    }
+    
+    if (!expand_path_token(resolver, loader, name, expanded, sizeof(expanded))) return 0;
+    return find_candidate(resolver, expanded, name[0] != '@', out, size, is_stub);
+}
+
+// Keep the LC_RPATH entries of a parsed image, tokens are expanded when they are used
+static macho_error_t collect_rpaths(dylib_node_t* node, const macho_ctx_t* ctx) {
+    if (ctx->lc_index.nrpaths == 0) return SUCCESS;
+    
+    node->rpaths = calloc(ctx->lc_index.nrpaths, sizeof(char*));
+    if (!node->rpaths) return ERROR_READ_FAILED;
+    
+    for (uint32_t i = 0; i < ctx->lc_index.nrpaths; i++) {
+        const load_command_t* lc = &ctx->load_commands[ctx->lc_index.rpaths[i]];
+        const struct rpath_command* rpath_cmd = (const struct rpath_command*)lc->data;
+        uint32_t offset = ctx->is_swap ? swap32(rpath_cmd->path.offset) : rpath_cmd->path.offset;
+        const char* rpath = load_command_string(lc, offset, sizeof(struct rpath_command));
+        if (!rpath) continue;
+        
+        node->rpaths[node->nrpaths] = strdup(rpath);
+        if (!node->rpaths[node->nrpaths]) return ERROR_READ_FAILED;
+        node->nrpaths++;
+    }
+    return SUCCESS;
+}
+
+// Size, UUID and install name of a parsed image
+static macho_error_t read_image_identity(dylib_node_t* node, const macho_ctx_t* ctx) {
+    node->size = ctx->size;
+    
+    if (ctx->lc_index.uuid) {
+        const struct uuid_command* uuid_cmd = (const struct uuid_command*)ctx->lc_index.uuid->data;
+        memcpy(node->uuid, uuid_cmd->uuid, sizeof(node->uuid));
+        node->has_uuid = 1;
+    }
+    
+    const load_command_t* lc = ctx->lc_index.id_dylib;
+    if (lc) {
+        const struct dylib_command* dylib_cmd = (const struct dylib_command*)lc->data;
+        uint32_t offset = ctx->is_swap ? swap32(dylib_cmd->dylib.name.offset) : dylib_cmd->dylib.name.offset;
+        const char* name = load_command_string(lc, offset, sizeof(struct dylib_command));
+        if (name) {
+            node->install_name = strdup(name);
+            if (!node->install_name) return ERROR_READ_FAILED;
+        }
+    }
+    return SUCCESS;
+}
+
+// Record a parsed image and resolve every dylib command it has. Only this image and the
+// rpaths of its loaders are read, and those were loaded by earlier levels.
+static macho_error_t resolve_dylibs(load_job_t* job, const macho_ctx_t* ctx) {
+    uint32_t dylib_count = ctx->lc_index.ndylibs;
+    
+    macho_error_t err = read_image_identity(job->node, ctx);
+    if (err == SUCCESS) {
+        err = collect_rpaths(job->node, ctx);
+    }
+    if (err != SUCCESS || dylib_count == 0) return err;
+    
+    job->dylibs = calloc(dylib_count, sizeof(resolved_dylib_t));
+    if (!job->dylibs) return ERROR_READ_FAILED;
+    
+    for (uint32_t i = 0; i < dylib_count; i++) {
+        const load_command_t* lc = &ctx->load_commands[ctx->lc_index.dylibs[i]];
+        if (lc->cmdsize < sizeof(struct dylib_command)) continue;
+        
+        const struct dylib_command* dylib_cmd = (const struct dylib_command*)lc->data;
+        uint32_t offset = ctx->is_swap ? swap32(dylib_cmd->dylib.name.offset) : dylib_cmd->dylib.name.offset;
+        const char* name = load_command_string(lc, offset, sizeof(struct dylib_command));
+        if (!name) continue;
+        
+        resolved_dylib_t* dylib = &job->dylibs[job->ndylibs++];
+        char path[PATH_MAX];
+        char canonical[PATH_MAX];
+        if (resolve_install_name(job->resolver, job->node, name, path, sizeof(path), &dylib->is_stub)) {
+            // Symlinked framework versions and ../ paths must land on the same cache entry
+            dylib->path = strdup(realpath(path, canonical) ? canonical : path);
+            if (!dylib->path) return ERROR_READ_FAILED;
+        }
+        dylib->name = strdup(name);
+        if (!dylib->name) return ERROR_READ_FAILED;
+        
+        dylib->timestamp = ctx->is_swap ? swap32(dylib_cmd->dylib.timestamp) : dylib_cmd->dylib.timestamp;
+        dylib->current_version = ctx->is_swap ? swap32(dylib_cmd->dylib.current_version) :
+                                                dylib_cmd->dylib.current_version;
+        dylib->compatibility_version = ctx->is_swap ? swap32(dylib_cmd->dylib.compatibility_version) :
+                                                      dylib_cmd->dylib.compatibility_version;
+    }
+    return SUCCESS;
+}
+
+// Link an image to everything it loads, adding the images seen for the first time.
+// New nodes are appended in load command order, they form the next level.
+static macho_error_t merge_dylibs(dylib_graph_t* graph, const load_job_t* job) {
+    dylib_node_t* node = job->node;
+    if (job->err != SUCCESS || job->ndylibs == 0) return job->err;
+    
+    node->dependencies = calloc(job->ndylibs, sizeof(dylib_node_t*));
+    if (!node->dependencies) return ERROR_READ_FAILED;
+    
+    for (uint32_t i = 0; i < job->ndylibs; i++) {
+        const resolved_dylib_t* dylib = &job->dylibs[i];
+        dylib_node_t* dep = find_node(graph, dylib->path ? dylib->path : dylib->name);
+        if (!dep) {
+            dep = add_node(graph, dylib->name, dylib->path);
+            if (!dep) return ERROR_READ_FAILED;
             
-            struct dylib_command* dylib_cmd = (struct dylib_command*)lc;
-            uint32_t name_offset = ctx->is_swap ? swap32(dylib_cmd->dylib.name.offset) : dylib_cmd->dylib.name.offset;
+            dep->loader = node;
+            dep->timestamp = dylib->timestamp;
+            dep->current_version = dylib->current_version;
+            dep->compatibility_version = dylib->compatibility_version;
+            dep->is_stub = dylib->is_stub;
+            if (!dylib->path) dep->status = ERROR_FILE_NOT_FOUND;
+        }
+        node->dependencies[node->dep_count++] = dep;
+    }
+    return SUCCESS;
+}
+
+static void free_load_jobs(load_job_t* jobs, uint32_t njobs) {
+    for (uint32_t i = 0; i < njobs; i++) {
+        for (uint32_t j = 0; j < jobs[i].ndylibs; j++) {
+            free(jobs[i].dylibs[j].name);
+            free(jobs[i].dylibs[j].path);
+        }
+        free(jobs[i].dylibs);
+    }
+    free(jobs);
+}
+
+// Slice with the architecture of the root image, the first one when none matches
+static uint32_t pick_slice(const resolver_t* resolver, const macho_file_t* file) {
+    uint32_t match = 0;
+    int found = 0;
+    
+    for (uint32_t i = 0; i < file->narchs; i++) {
+        if (file->archs[i].cputype != resolver->cputype) continue;
+        if ((file->archs[i].cpusubtype & ~CPU_SUBTYPE_MASK) == (resolver->cpusubtype & ~CPU_SUBTYPE_MASK)) {
+            return i;
+        }
+        if (!found) {
+            match = i;
+            found = 1;
+        }
+    }
+    return match;
+}
+
+// Worker task: parse one dependency and resolve what it loads. The file is closed again
+// before the task ends, images that fail to parse keep the error in their status.
+static void load_image_task(void* arg) {
+    load_job_t* job = (load_job_t*)arg;
+    dylib_node_t* node = job->node;
+    macho_file_t file;
+    
+    node->status = open_macho_file(&file, node->path);
+    if (node->status != SUCCESS) return;
+    
+    macho_ctx_t ctx;
+    node->status = parse_macho_slice(&ctx, &file, pick_slice(job->resolver, &file));
+    if (node->status == SUCCESS) {
+        job->err = resolve_dylibs(job, &ctx);
+    }
+    free_macho_context(&ctx);
+    close_macho_file(&file);
+}
+
+// Read the LC_RPATH entries of a main executable given separately from the root image
+static void load_executable_rpaths(const resolver_t* resolver, dylib_node_t* executable) {
+    macho_file_t file;
+    if (open_macho_file(&file, executable->path) != SUCCESS) return;
+    
+    macho_ctx_t ctx;
+    if (parse_macho_slice(&ctx, &file, pick_slice(resolver, &file)) == SUCCESS) {
+        collect_rpaths(executable, &ctx);
+    }
+    free_macho_context(&ctx);
+    close_macho_file(&file);
+}
+
+// Tarjan frame: a node and the next of its edges to follow
+typedef struct {
+    uint32_t node;
+    uint32_t edge;
+} scc_frame_t;
+
+// Tarjan's strongly connected components without recursion. Components are numbered in
+// reverse topological order, everything a component loads has a lower number.
+static macho_error_t find_components(const dylib_graph_t* graph, uint32_t* component, uint32_t* ncomponents) {
+    uint32_t n = graph->count;
+    uint32_t* index = calloc(n, sizeof(uint32_t));     // DFS order + 1, 0 when unvisited
+    uint32_t* low = calloc(n, sizeof(uint32_t));
+    uint32_t* stack = calloc(n, sizeof(uint32_t));
+    uint8_t* on_stack = calloc(n, sizeof(uint8_t));
+    scc_frame_t* calls = calloc(n, sizeof(scc_frame_t));
+    if (!index || !low || !stack || !on_stack || !calls) {
+        free(index);
+        free(low);
+        free(stack);
+        free(on_stack);
+        free(calls);
+        return ERROR_READ_FAILED;
+    }
+    
+    uint32_t counter = 0;
+    uint32_t sp = 0;
+    uint32_t count = 0;
+    for (uint32_t start = 0; start < n; start++) {
+        if (index[start]) continue;
+        
+        uint32_t depth = 0;
+        calls[depth++] = (scc_frame_t){ start, 0 };
+        index[start] = low[start] = ++counter;
+        stack[sp++] = start;
+        on_stack[start] = 1;
+        
+        while (depth > 0) {
+            scc_frame_t* frame = &calls[depth - 1];
+            uint32_t v = frame->node;
+            const dylib_node_t* node = graph->nodes[v];
             
-            if (name_offset >= sizeof(struct dylib_command)) {
-                char* name = (char*)dylib_cmd + name_offset;
-                
-                // Validate string length
-                size_t max_len = (char*)lc + dylib_cmd->cmdsize - name;
-                size_t name_len = strnlen(name, max_len);
-                
-                if (name_len < max_len) {
-                    (*dylibs)[index] = strdup(name);
-                    index++;
+            if (frame->edge < node->dep_count) {
+                uint32_t w = node->dependencies[frame->edge++]->id;
+                if (!index[w]) {
+                    index[w] = low[w] = ++counter;
+                    stack[sp++] = w;
+                    on_stack[w] = 1;
+                    calls[depth++] = (scc_frame_t){ w, 0 };
+                } else if (on_stack[w] && index[w] < low[v]) {
+                    low[v] = index[w];
                 }
+                continue;
+            }
+            
+            // v is the root of a component once nothing below it reaches higher
+            if (low[v] == index[v]) {
+                uint32_t w;
+                do {
+                    w = stack[--sp];
+                    on_stack[w] = 0;
+                    component[w] = count;
+                } while (w != v);
+                count++;
+            }
+            
+            depth--;
+            if (depth > 0) {
+                uint32_t parent = calls[depth - 1].node;
+                if (low[v] < low[parent]) low[parent] = low[v];
             }
         }
     }
     
-    *count = index;
+    *ncomponents = count;
+    free(index);
+    free(low);
+    free(stack);
+    free(on_stack);
+    free(calls);
     return SUCCESS;
 }
 
-// Build dependency tree (simplified version)
-macho_error_t build_dependency_tree(const macho_ctx_t* ctx, dylib_node_t** root) {
-    if (!ctx || !root) return ERROR_READ_FAILED;
+// Number the cycles in node order and total what each image pulls in. Every component
+// keeps a bitset of the images it reaches, built from the components it loads.
+static macho_error_t analyze_components(dylib_graph_t* graph) {
+    uint32_t n = graph->count;
+    uint32_t ncomponents = 0;
+    uint32_t* component = calloc(n, sizeof(uint32_t));
+    if (!component) return ERROR_READ_FAILED;
     
-    char** dylibs = NULL;
-    uint32_t dylib_count = 0;
-    macho_error_t err = find_dylib_dependencies(ctx, &dylibs, &dylib_count);
-    if (err != SUCCESS) {
-        return err;
+    macho_error_t err = find_components(graph, component, &ncomponents);
+    
+    size_t words = ((size_t)n + 63) / 64;
+    uint32_t* first = NULL;         // Members of each component, grouped by a counting sort
+    uint32_t* members = NULL;
+    uint32_t* cycle = NULL;
+    uint64_t* reach = NULL;
+    uint64_t* weights = NULL;
+    if (err == SUCCESS) {
+        first = calloc((size_t)ncomponents + 1, sizeof(uint32_t));
+        members = calloc(n, sizeof(uint32_t));
+        cycle = calloc(ncomponents, sizeof(uint32_t));
+        reach = calloc((size_t)ncomponents * words, sizeof(uint64_t));
+        weights = calloc(ncomponents, sizeof(uint64_t));
+        if (!first || !members || !cycle || !reach || !weights) err = ERROR_READ_FAILED;
     }
     
-    // Create root node (the main binary)
-    *root = calloc(1, sizeof(dylib_node_t));
-    if (!*root) {
-        for (uint32_t i = 0; i < dylib_count; i++) {
-            free(dylibs[i]);
+    if (err == SUCCESS) {
+        for (uint32_t i = 0; i < n; i++) {
+            first[component[i] + 1]++;
+        }
+        for (uint32_t c = 0; c < ncomponents; c++) {
+            first[c + 1] += first[c];
+        }
+        uint32_t* fill = cycle;     // Reused as insert positions, cleared below
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t c = component[i];
+            members[first[c] + fill[c]++] = i;
+        }
+        memset(cycle, 0, ncomponents * sizeof(uint32_t));
+        
+        // A cycle is a component of several images, or an image that loads itself
+        graph->ncycles = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t c = component[i];
+            const dylib_node_t* node = graph->nodes[i];
+            int cyclic = first[c + 1] - first[c] > 1;
+            for (uint32_t j = 0; j < node->dep_count && !cyclic; j++) {
+                cyclic = node->dependencies[j] == node;
+            }
+            if (cyclic && !cycle[c]) {
+                cycle[c] = ++graph->ncycles;
+            }
+            graph->nodes[i]->cycle = cycle[c];
+        }
+        
+        for (uint32_t c = 0; c < ncomponents; c++) {
+            uint64_t* bits = reach + (size_t)c * words;
+            for (uint32_t m = first[c]; m < first[c + 1]; m++) {
+                const dylib_node_t* node = graph->nodes[members[m]];
+                bits[node->id / 64] |= 1ULL << (node->id % 64);
+                for (uint32_t j = 0; j < node->dep_count; j++) {
+                    uint32_t d = component[node->dependencies[j]->id];
+                    if (d == c) continue;
+                    const uint64_t* dep_bits = reach + (size_t)d * words;
+                    for (size_t w = 0; w < words; w++) {
+                        bits[w] |= dep_bits[w];
+                    }
+                }
+            }
+            for (uint32_t i = 0; i < n; i++) {
+                if (bits[i / 64] & (1ULL << (i % 64))) weights[c] += graph->nodes[i]->size;
+            }
         }
-        free(dylibs);
+        for (uint32_t i = 0; i < n; i++) {
+            graph->nodes[i]->weight = weights[component[i]];
+        }
+    }
+    
+    free(component);
+    free(first);
+    free(members);
+    free(cycle);
+    free(reach);
+    free(weights);
+    return err;
+}
+
+static int uuid_key(const dylib_node_t* a, const dylib_node_t* b) {
+    return memcmp(a->uuid, b->uuid, sizeof(a->uuid));
+}
+
+static int install_name_key(const dylib_node_t* a, const dylib_node_t* b) {
+    return strcmp(a->install_name, b->install_name);
+}
+
+// Order by UUID, then by id so the first copy of an image comes first
+static int compare_uuid(const void* a, const void* b) {
+    const dylib_node_t* na = *(const dylib_node_t* const*)a;
+    const dylib_node_t* nb = *(const dylib_node_t* const*)b;
+    int cmp = uuid_key(na, nb);
+    if (cmp != 0) return cmp;
+    return na->id < nb->id ? -1 : na->id > nb->id;
+}
+
+static int compare_install_name(const void* a, const void* b) {
+    const dylib_node_t* na = *(const dylib_node_t* const*)a;
+    const dylib_node_t* nb = *(const dylib_node_t* const*)b;
+    int cmp = install_name_key(na, nb);
+    if (cmp != 0) return cmp;
+    return na->id < nb->id ? -1 : na->id > nb->id;
+}
+
+// Mark later images of each run of equal keys as duplicates of the first one
+static void mark_duplicates(dylib_node_t** sorted, uint32_t count, int (*compare)(const void*, const void*),
+                            int (*key)(const dylib_node_t*, const dylib_node_t*)) {
+    qsort(sorted, count, sizeof(dylib_node_t*), compare);
+    
+    uint32_t run = 0;
+    for (uint32_t i = 1; i < count; i++) {
+        dylib_node_t* first = sorted[run];
+        if (key(first, sorted[i]) != 0) {
+            run = i;
+        } else if (!sorted[i]->duplicate_of) {
+            sorted[i]->duplicate_of = first->duplicate_of ? first->duplicate_of : first;
+        }
+    }
+}
+
+// Two files with the same UUID are copies of one binary, two with the same install name are
+// versions of one library that would both be loaded. Repeated load commands are counted too.
+static macho_error_t find_duplicates(dylib_graph_t* graph) {
+    uint32_t n = graph->count;
+    dylib_node_t** sorted = calloc(n, sizeof(dylib_node_t*));
+    uint32_t* seen = calloc(n, sizeof(uint32_t));      // Loader id + 1 that last reached a node
+    if (!sorted || !seen) {
+        free(sorted);
+        free(seen);
         return ERROR_READ_FAILED;
     }
     
-    (*root)->name = strdup("Main Binary");
-    (*root)->path = NULL;
-    (*root)->dependencies = calloc(dylib_count, sizeof(dylib_node_t*));
-    (*root)->dep_count = dylib_count;
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (graph->nodes[i]->has_uuid) sorted[count++] = graph->nodes[i];
+    }
+    mark_duplicates(sorted, count, compare_uuid, uuid_key);
     
-    // Create dependency nodes (simplified - no recursive loading)
-    for (uint32_t i = 0; i < dylib_count; i++) {
-        dylib_node_t* dep = calloc(1, sizeof(dylib_node_t));
-        if (dep) {
-            dep->name = strdup(dylibs[i]);
-            dep->path = strdup(dylibs[i]); // In real implementation, resolve path
-            dep->dependencies = NULL;
-            dep->dep_count = 0;
-            (*root)->dependencies[i] = dep;
+    count = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (graph->nodes[i]->install_name) sorted[count++] = graph->nodes[i];
+    }
+    mark_duplicates(sorted, count, compare_install_name, install_name_key);
+    
+    graph->nduplicates = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        dylib_node_t* node = graph->nodes[i];
+        if (node->duplicate_of) graph->nduplicates++;
+        
+        for (uint32_t j = 0; j < node->dep_count; j++) {
+            uint32_t id = node->dependencies[j]->id;
+            if (seen[id] == i + 1) {
+                node->duplicate_loads++;
+            }
+            seen[id] = i + 1;
         }
-        free(dylibs[i]);
     }
     
-    free(dylibs);
+    free(sorted);
+    free(seen);
     return SUCCESS;
 }
 
-// Print dependency tree with indentation
-void print_dependency_tree(const dylib_node_t* node, int depth) {
-    if (!node) return;
+// Resolve the whole closure of an image into a DAG. Install names are expanded against the
+// LC_RPATH entries of the load chain, the main executable, the loader and the SDK root, and
+// every file is parsed once no matter how many images load it. The closure is loaded one
+// breadth-first level at a time, the images of a level are parsed on the thread pool.
+macho_error_t build_dependency_tree(const macho_ctx_t* ctx, const char* path, const dependency_options_t* opts,
+                                    dylib_graph_t* graph) {
+    if (!ctx || !path || !graph) return ERROR_READ_FAILED;
+    
+    memset(graph, 0, sizeof(dylib_graph_t));
+    
+    resolver_t* resolver = calloc(1, sizeof(resolver_t));
+    if (!resolver) return ERROR_READ_FAILED;
+    resolver->opts = opts;
+    resolver->cputype = ctx->cputype;
+    resolver->cpusubtype = ctx->cpusubtype;
+    
+    char root_path[PATH_MAX];
+    if (!realpath(path, root_path)) {
+        snprintf(root_path, sizeof(root_path), "%s", path);
+    }
+    
+    // Without an explicit main executable, @executable_path only means something for one.
+    // An explicit one ends every load chain, so its rpaths are searched last like in dyld.
+    dylib_node_t executable = { 0 };
+    char executable_path[PATH_MAX];
+    if (opts && opts->executable_path) {
+        if (!realpath(opts->executable_path, executable_path)) {
+            snprintf(executable_path, sizeof(executable_path), "%s", opts->executable_path);
+        }
+        path_dirname(executable_path, resolver->executable_dir, sizeof(resolver->executable_dir));
+        executable.path = executable_path;
+        load_executable_rpaths(resolver, &executable);
+        resolver->executable = &executable;
+    } else if (ctx->filetype == MH_EXECUTE) {
+        path_dirname(root_path, resolver->executable_dir, sizeof(resolver->executable_dir));
+    }
+    
+    macho_error_t err = ERROR_READ_FAILED;
+    load_job_t* jobs = calloc(1, sizeof(load_job_t));
+    dylib_node_t* root = jobs ? add_node(graph, path, root_path) : NULL;
+    uint32_t njobs = 0;
+    if (root) {
+        jobs[0].resolver = resolver;
+        jobs[0].node = root;
+        jobs[0].err = resolve_dylibs(&jobs[0], ctx);
+        njobs = 1;
+        err = SUCCESS;
+    }
     
-    // Create indentation
-    for (int i = 0; i < depth; i++) {
-        printf("  ");
+    thread_pool_t* pool = NULL;
+    uint32_t level_start = graph->count;
+    while (njobs > 0 && err == SUCCESS) {
+        // Merged in frontier order on this thread, so ids and load chains do not depend
+        // on which worker finished first
+        for (uint32_t i = 0; i < njobs && err == SUCCESS; i++) {
+            err = merge_dylibs(graph, &jobs[i]);
+        }
+        free_load_jobs(jobs, njobs);
+        jobs = NULL;
+        njobs = 0;
+        if (err != SUCCESS) break;
+        
+        // Next level: every new image that has a file to parse
+        uint32_t level_end = graph->count;
+        for (uint32_t i = level_start; i < level_end; i++) {
+            if (graph->nodes[i]->path && !graph->nodes[i]->is_stub) njobs++;
+        }
+        if (njobs == 0) break;
+        
+        jobs = calloc(njobs, sizeof(load_job_t));
+        if (!jobs) {
+            err = ERROR_READ_FAILED;
+            njobs = 0;
+            break;
+        }
+        if (!pool && njobs > 1) {
+            pool = thread_pool_create(opts ? opts->nthreads : 0, 0);
+        }
+        
+        uint32_t next = 0;
+        for (uint32_t i = level_start; i < level_end; i++) {
+            dylib_node_t* node = graph->nodes[i];
+            if (!node->path || node->is_stub) continue;
+            
+            load_job_t* job = &jobs[next++];
+            job->resolver = resolver;
+            job->node = node;
+            if (!pool || thread_pool_submit(pool, load_image_task, job) != SUCCESS) {
+                load_image_task(job);
+            }
+        }
+        if (pool) {
+            thread_pool_wait(pool);
+        }
+        level_start = level_end;
     }
     
-    printf("└─ %s", node->name);
-    if (node->path && strcmp(node->name, node->path) != 0) {
-        printf(" (%s)", node->path);
+    if (err == SUCCESS) {
+        err = analyze_components(graph);
+    }
+    if (err == SUCCESS) {
+        err = find_duplicates(graph);
     }
-    printf("\n");
     
-    // Print dependencies
-    for (uint32_t i = 0; i < node->dep_count; i++) {
-        print_dependency_tree(node->dependencies[i], depth + 1);
+    free_load_jobs(jobs, njobs);
+    if (pool) {
+        thread_pool_destroy(pool);
+    }
+    for (uint32_t i = 0; i < executable.nrpaths; i++) {
+        free(executable.rpaths[i]);
+    }
+    free(executable.rpaths);
+    free(resolver);
+    if (err != SUCCESS) {
+        free_dependency_tree(graph);
     }
+    return err;
 }
 
-// Free dependency tree memory
-void free_dependency_tree(dylib_node_t* node) {
-    if (!node) return;
+// Reference to another image: its name for people, its id for tools
+static void output_inline_image(output_t* out, const char* key, const char* label, const dylib_node_t* node) {
+    output_begin_inline(out, key, label);
+    output_str(out, "name", "", node->name);
+    output_uint(out, "image", NULL, node->id);
+    output_end_object(out);
+}
+
+// Print every image of the graph once, with the images it loads and what it weighs
+void print_dependency_tree(output_t* out, const dylib_graph_t* graph) {
+    if (!graph) return;
     
-    if (node->name) free(node->name);
-    if (node->path) free(node->path);
+    uint32_t unresolved = 0;
+    output_begin_object(out, "dependency_graph", "Dependency Graph");
+    output_uint(out, "count", "Images", graph->count);
+    output_begin_stream(out, "images", NULL, graph->count);
+    for (uint32_t i = 0; i < graph->count; i++) {
+        const dylib_node_t* node = graph->nodes[i];
+        
+        output_begin_object(out, "image", node->name);
+        output_uint(out, "id", NULL, node->id);
+        output_str(out, "name", NULL, node->name);
+        if (node->path) {
+            output_str(out, "path", "Path", node->path);
+        }
+        if (node->is_stub) {
+            output_bool(out, "stub", "Stub", 1);
+        }
+        if (node->status != SUCCESS) {
+            output_str(out, "error", "Error", macho_strerror(node->status));
+            unresolved++;
+        }
+        if (node->install_name && strcmp(node->install_name, node->name) != 0) {
+            output_str(out, "install_name", "Install name", node->install_name);
+        }
+        if (node->size) {
+            output_uint(out, "size", "Size", node->size);
+            output_uint(out, "weight", "Closure size", node->weight);
+        }
+        if (node->cycle) {
+            output_uint(out, "cycle", "Cycle", node->cycle);
+        }
+        if (node->duplicate_of) {
+            output_inline_image(out, "duplicate_of", "Duplicate of", node->duplicate_of);
+        }
+        if (node->duplicate_loads) {
+            output_uint(out, "duplicate_loads", "Duplicate loads", node->duplicate_loads);
+        }
+        
+        if (node->nrpaths > 0) {
+            output_begin_array(out, "rpaths", "Rpaths", node->nrpaths);
+            for (uint32_t j = 0; j < node->nrpaths; j++) {
+                output_str(out, "rpath", NULL, node->rpaths[j]);
+            }
+            output_end_array(out);
+        }
+        
+        if (node->dep_count > 0) {
+            output_begin_array(out, "dependencies", "Dependencies", node->dep_count);
+            for (uint32_t j = 0; j < node->dep_count; j++) {
+                output_inline_image(out, "dependency", NULL, node->dependencies[j]);
+            }
+            output_end_array(out);
+        }
+        output_end_object(out);
+    }
+    output_end_array(out);
     
-    for (uint32_t i = 0; i < node->dep_count; i++) {
-        free_dependency_tree(node->dependencies[i]);
+    output_uint(out, "closure_size", "Closure size", graph->count ? graph->nodes[0]->weight : 0);
+    output_uint(out, "cycles", "Cycles", graph->ncycles);
+    output_uint(out, "duplicates", "Duplicate images", graph->nduplicates);
+    output_uint(out, "errors", "Images with errors", unresolved);
+    output_end_object(out);
+}
+
+// Quoted DOT string, quotes and backslashes escaped
+static void write_dot_string(output_t* out, const char* str) {
+    output_write(out, "\"", 1);
+    for (const char* p = str; *p; p++) {
+        if (*p == '"' || *p == '\\') output_write(out, "\\", 1);
+        output_write(out, p, 1);
     }
+    output_write(out, "\"", 1);
+}
+
+// Graphviz digraph: boxes sized by closure, cycles in red, unresolved images dashed
+void print_dependency_dot(output_t* out, const dylib_graph_t* graph) {
+    if (!graph) return;
     
-    if (node->dependencies) {
-        free(node->dependencies);
+    char line[128];
+    output_text(out, "digraph dependencies {\n");
+    output_text(out, "  node [shape=box, fontname=\"Helvetica\"];\n");
+    for (uint32_t i = 0; i < graph->count; i++) {
+        const dylib_node_t* node = graph->nodes[i];
+        
+        snprintf(line, sizeof(line), "  n%u [label=", node->id);
+        output_text(out, line);
+        write_dot_string(out, node->name);
+        if (node->size) {
+            snprintf(line, sizeof(line), ", tooltip=\"size %llu, closure %llu\"",
+                     (unsigned long long)node->size, (unsigned long long)node->weight);
+            output_text(out, line);
+        }
+        if (node->status != SUCCESS) output_text(out, ", style=dashed");
+        if (node->cycle) output_text(out, ", color=red");
+        if (node->duplicate_of) output_text(out, ", color=orange");
+        output_text(out, "];\n");
     }
+    for (uint32_t i = 0; i < graph->count; i++) {
+        const dylib_node_t* node = graph->nodes[i];
+        for (uint32_t j = 0; j < node->dep_count; j++) {
+            const dylib_node_t* dep = node->dependencies[j];
+            int in_cycle = node->cycle && dep->cycle == node->cycle;
+            snprintf(line, sizeof(line), "  n%u -> n%u%s;\n", node->id, dep->id, in_cycle ? " [color=red]" : "");
+            output_text(out, line);
+        }
+    }
+    output_text(out, "}\n");
+}
+
+// One "loader<TAB>dependency" line per load command, by name so releases can be diffed
+void print_dependency_edges(output_t* out, const dylib_graph_t* graph) {
+    if (!graph) return;
     
-    free(node);
+    for (uint32_t i = 0; i < graph->count; i++) {
+        const dylib_node_t* node = graph->nodes[i];
+        for (uint32_t j = 0; j < node->dep_count; j++) {
+            output_text(out, node->name);
+            output_write(out, "\t", 1);
+            output_text(out, node->dependencies[j]->name);
+            output_write(out, "\n", 1);
+        }
+    }
+}
 
+int dep_graph_format_from_name(const char* name, dep_graph_format_t* format) {
+    if (!name || !format) return 0;
+    
+    if (strcmp(name, "dot") == 0) {
+        *format = DEP_GRAPH_DOT;
+    } else if (strcmp(name, "json") == 0) {
+        *format = DEP_GRAPH_JSON;
+    } else if (strcmp(name, "edges") == 0) {
+        *format = DEP_GRAPH_EDGES;
+    } else {
+        return 0;
+    }
+    return 1;
 }
 
+// Free every node of the graph and the path cache
+void free_dependency_tree(dylib_graph_t* graph) {
+    if (!graph) return;
+    
+    for (uint32_t i = 0; i < graph->count; i++) {
+        dylib_node_t* node = graph->nodes[i];
+        for (uint32_t j = 0; j < node->nrpaths; j++) {
+            free(node->rpaths[j]);
+        }
+        free(node->rpaths);
+        free(node->dependencies);
+        free(node->name);
+        free(node->path);
+        free(node->install_name);
+        free(node);
+    }
+    free(graph->nodes);
+    free(graph->table);
+    memset(graph, 0, sizeof(dylib_graph_t));
+
+}
@@ -60,6 +60,70 @@ void free_file(void* data) {
     free(data);
 }
 
+// Map file read-only into memory, no copy is made
+void* map_file(const char* filename, size_t* size) {
+    if (!filename || !size) return NULL;
+    
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) {
+        debug_print("Failed to open file: %s\n", strerror(errno));
+        return NULL;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        debug_print("Failed to stat file: %s\n", strerror(errno));
+        close(fd);
+        return NULL;
+    }
+    
+    if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+        debug_print("File is empty or not a regular file\n");
+        close(fd);
+        return NULL;
+    }
+    
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        debug_print("Failed to map file: %s\n", strerror(errno));
+        return NULL;
+    }
+    
+    *size = st.st_size;
+    debug_print("Successfully mapped %zu bytes from %s\n", *size, filename);
+    return data;
+}
+
+// Unmap file data
+void unmap_file(void* data, size_t size) {
+    if (data) munmap(data, size);
+}
+
+// Give the kernel a paging hint for a byte range of a mapped file
+void advise_file_range(const void* base, size_t size, uint64_t offset, uint64_t length, file_advice_t advice) {
+    if (!base || offset >= size || length == 0) return;
+    if (length > size - offset) length = size - offset;
+    
+    // madvise needs a page-aligned start address
+    uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)base + offset;
+    uintptr_t aligned = start & ~(page_size - 1);
+    size_t aligned_length = length + (start - aligned);
+    
+    int madv = MADV_NORMAL;
+    switch (advice) {
+        case ADVISE_WILLNEED: madv = MADV_WILLNEED; break;
+        case ADVISE_RANDOM: madv = MADV_RANDOM; break;
+        case ADVISE_SEQUENTIAL: madv = MADV_SEQUENTIAL; break;
+        default: madv = MADV_NORMAL; break;
+    }
+    
+    if (madvise((void*)aligned, aligned_length, madv) == -1) {
+        debug_print("madvise failed: %s\n", strerror(errno));
+    }
+}
+
 // Validate Mach-O magic number
 int validate_magic(uint32_t magic) {
     switch (magic) {
@@ -69,6 +133,8 @@ int validate_magic(uint32_t magic) {
         case MH_CIGAM_64:
         case FAT_MAGIC:
         case FAT_CIGAM:
+        case FAT_MAGIC_64:
+        case FAT_CIGAM_64:
             return 1;
         default:
             return 0;
@@ -173,6 +239,44 @@ void* safe_memcpy(void* dest, const void* src, size_t n, const void* base, size_
 size_t calculate_padding(size_t offset, size_t alignment) {
     if (alignment == 0) return 0;
     return (alignment - (offset % alignment)) % alignment;
+}
+
+// Grow a string buffer so it can hold extra more bytes
+static int strbuf_reserve(strbuf_t* buf, size_t extra) {
+    if (buf->len + extra + 1 <= buf->cap) return 1;
+    
+    size_t cap = buf->cap ? buf->cap : 256;
+    while (cap < buf->len + extra + 1) {
+        cap *= 2;
+    }
+    
+    char* data = realloc(buf->data, cap);
+    if (!data) return 0;
+    
+    buf->data = data;
+    buf->cap = cap;
+    return 1;
+}
+
+void strbuf_init(strbuf_t* buf) {
+    buf->data = NULL;
+    buf->len = 0;
+    buf->cap = 0;
+}
+
+void strbuf_append(strbuf_t* buf, const char* str, size_t len) {
+    if (!buf || !str || !strbuf_reserve(buf, len)) return;
+    
+    memcpy(buf->data + buf->len, str, len);
+    buf->len += len;
+    buf->data[buf->len] = '\0';
+}
+
+void strbuf_free(strbuf_t* buf) {
+    if (!buf) return;
+    
+    free(buf->data);
+    strbuf_init(buf);
 
 }
 